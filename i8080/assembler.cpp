@@ -0,0 +1,652 @@
+//**************************************
+// assembler.cpp
+//
+// Holds the definition of the 8080
+// assembler, which turns source text
+// into machine code in one pass over
+// the text, using the same mnemonic
+// table as the disassembler
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "assembler.h"
+
+#include <algorithm>
+
+#include "i8080.h"
+#include "mnemonics.h"
+#include "symbol_table.h"
+
+namespace i8080
+{
+	// a mnemonic's shape: how many fixed register operands
+	// come first and what immediate follows them
+	struct Shape
+	{
+		uint8_t registers;
+		OperandFormat format;
+	};
+
+	// the mnemonic table turned around, built once on first use
+	struct OpcodeIndex
+	{
+		// "MOV A,B", "LXI H", "JMP" and so on to their opcodes,
+		// keeping the documented opcode where there are two
+		std::unordered_map<std::string, uint8_t> opcodes;
+		std::unordered_map<std::string, Shape> shapes;
+	};
+
+	//**********************************
+	// Get the opcode index
+	//**********************************
+	static const OpcodeIndex& opcode_index()
+	{
+		static const OpcodeIndex index = []
+		{
+			OpcodeIndex built;
+			for (int op = 0; op < 256; ++op)
+			{
+				const MnemonicInfo& info = mnemonics[op];
+				std::string key(info.name);
+				if (!info.operands.empty())
+				{
+					key += ' ';
+					key += info.operands;
+				}
+				built.opcodes.emplace(key, static_cast<uint8_t>(op));
+
+				uint8_t registers = info.operands.empty() ? 0 : static_cast<uint8_t>(1 + std::count(info.operands.begin(), info.operands.end(), ','));
+				built.shapes.emplace(std::string(info.name), Shape{ registers, info.format });
+			}
+			return built;
+		}();
+		return index;
+	}
+
+	static inline bool is_space(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+	static inline bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+	static inline bool is_letter(char c) noexcept { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+	static inline bool is_name_start(char c) noexcept { return is_letter(c) || c == '_' || c == '.' || c == '?' || c == '@'; }
+	static inline bool is_name(char c) noexcept { return is_name_start(c) || is_digit(c); }
+	static inline char upper(char c) noexcept { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c; }
+
+	//**********************************
+	// Trim whitespace off both ends
+	//**********************************
+	static std::string_view trim(std::string_view text) noexcept
+	{
+		while (!text.empty() && is_space(text.front())) text.remove_prefix(1);
+		while (!text.empty() && is_space(text.back())) text.remove_suffix(1);
+		return text;
+	}
+
+	//**********************************
+	// Get the length of the name at the
+	// start of some text, or 0
+	//**********************************
+	static size_t name_length(std::string_view text) noexcept
+	{
+		if (text.empty() || !is_name_start(text[0])) return 0;
+		size_t length = 1;
+		while (length < text.size() && is_name(text[length])) ++length;
+		return length;
+	}
+
+	//**********************************
+	// Check a word against an upper
+	// case keyword, ignoring case
+	//**********************************
+	static bool keyword(std::string_view word, std::string_view upper_case) noexcept
+	{
+		if (word.size() != upper_case.size()) return false;
+		for (size_t i = 0; i < word.size(); ++i)
+			if (upper(word[i]) != upper_case[i]) return false;
+		return true;
+	}
+
+	//**********************************
+	// Split operands on the commas that
+	// aren't inside quotes, returning
+	// how many there were
+	//**********************************
+	static size_t split(std::string_view text, std::string_view* operands, size_t capacity)
+	{
+		text = trim(text);
+		if (text.empty()) return 0;
+
+		size_t count = 0;
+		size_t begin = 0;
+		char quote = 0;
+		for (size_t i = 0; i <= text.size(); ++i)
+		{
+			char c = i < text.size() ? text[i] : ',';
+			if (quote)
+			{
+				if (c == quote) quote = 0;
+			}
+			else if (c == '\'' || c == '"')
+				quote = c;
+			else if (c == ',')
+			{
+				if (count == capacity) throw -1;
+				operands[count++] = trim(text.substr(begin, i - begin));
+				begin = i + 1;
+			}
+		}
+		if (quote) throw -1;
+		return count;
+	}
+
+	// a recursive descent parser over one expression, with
+	// the usual C precedence
+	struct Expression
+	{
+		const std::unordered_map<std::string, uint16_t>& symbols;
+		std::string& name;
+		std::string_view text;
+		uint16_t location;
+		size_t pos = 0;
+		// cleared by the first undefined symbol, after which
+		// the value is meaningless but the syntax still checked
+		bool known = true;
+
+		char peek() noexcept
+		{
+			while (pos < text.size() && is_space(text[pos])) ++pos;
+			return pos < text.size() ? text[pos] : 0;
+		}
+
+		bool accept(std::string_view token) noexcept
+		{
+			peek();
+			if (text.substr(pos, token.size()) != token) return false;
+			pos += token.size();
+			return true;
+		}
+
+		int64_t number()
+		{
+			size_t begin = pos;
+			while (pos < text.size() && (is_digit(text[pos]) || is_letter(text[pos]))) ++pos;
+			std::string_view digits = text.substr(begin, pos - begin);
+
+			int base = 10;
+			if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+			{
+				base = 16;
+				digits.remove_prefix(2);
+			}
+			else if (upper(digits.back()) == 'H')
+			{
+				base = 16;
+				digits.remove_suffix(1);
+			}
+			else if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'b' || digits[1] == 'B'))
+			{
+				base = 2;
+				digits.remove_prefix(2);
+			}
+			else if (digits.size() > 1 && upper(digits.back()) == 'B')
+			{
+				base = 2;
+				digits.remove_suffix(1);
+			}
+			if (digits.empty()) throw -1;
+
+			uint32_t value = 0;
+			for (char c : digits)
+			{
+				int digit = is_digit(c) ? c - '0' : upper(c) - 'A' + 10;
+				if (digit >= base) throw -1;
+				value = value * base + digit;
+				if (value > 0xFFFF) throw -1;
+			}
+			return value;
+		}
+
+		// every intermediate result has to fit in 32 bits, which
+		// keeps the 64 bit arithmetic below from ever overflowing
+		static int64_t checked(int64_t value)
+		{
+			if (value < INT32_MIN || value > INT32_MAX) throw -1;
+			return value;
+		}
+
+		int64_t primary()
+		{
+			char c = peek();
+			if (c == '(')
+			{
+				++pos;
+				int64_t value = bitwise_or();
+				if (!accept(")")) throw -1;
+				return value;
+			}
+			if (c == '\'')
+			{
+				if (pos + 2 >= text.size() || text[pos + 2] != '\'') throw -1;
+				int64_t value = static_cast<uint8_t>(text[pos + 1]);
+				pos += 3;
+				return value;
+			}
+			if (c == '$')
+			{
+				++pos;
+				return location;
+			}
+			if (is_digit(c)) return number();
+
+			size_t length = name_length(text.substr(pos));
+			if (!length) throw -1;
+			name.assign(text.data() + pos, length);
+			pos += length;
+			auto symbol = symbols.find(name);
+			if (symbol == symbols.end())
+			{
+				known = false;
+				return 0;
+			}
+			return symbol->second;
+		}
+
+		int64_t unary()
+		{
+			if (accept("-")) return checked(-unary());
+			if (accept("+")) return unary();
+			if (accept("~")) return ~unary();
+			return primary();
+		}
+
+		int64_t multiply()
+		{
+			int64_t value = unary();
+			while (true)
+			{
+				if (accept("*")) value = checked(value * unary());
+				else if (accept("/") || accept("%"))
+				{
+					bool divide = text[pos - 1] == '/';
+					int64_t divisor = unary();
+					if (!known) value = 0;
+					else if (!divisor) throw -1;
+					else value = checked(divide ? value / divisor : value % divisor);
+				}
+				else return value;
+			}
+		}
+
+		int64_t add()
+		{
+			int64_t value = multiply();
+			while (true)
+			{
+				if (accept("+")) value = checked(value + multiply());
+				else if (accept("-")) value = checked(value - multiply());
+				else return value;
+			}
+		}
+
+		int64_t shift()
+		{
+			int64_t value = add();
+			while (true)
+			{
+				bool left = accept("<<");
+				if (!left && !accept(">>")) return value;
+				int64_t count = add();
+				if (count < 0 || count > 31) throw -1;
+				// shifting left by multiplying keeps negative values defined
+				value = checked(left ? value * (int64_t(1) << count) : value >> count);
+			}
+		}
+
+		int64_t bitwise_and()
+		{
+			int64_t value = shift();
+			while (accept("&")) value &= shift();
+			return value;
+		}
+
+		int64_t bitwise_xor()
+		{
+			int64_t value = bitwise_and();
+			while (accept("^")) value ^= bitwise_and();
+			return value;
+		}
+
+		int64_t bitwise_or()
+		{
+			int64_t value = bitwise_xor();
+			while (accept("|")) value |= bitwise_xor();
+			return value;
+		}
+	};
+
+	//**********************************
+	// Constructor
+	//**********************************
+	Assembler::Assembler() : image(0x10000, 0)
+	{
+		// build the index now rather than in the first assemble
+		opcode_index();
+	}
+
+	//**********************************
+	// Define a symbol
+	//**********************************
+	void Assembler::define(const std::string& name, uint16_t value)
+	{
+		symbols[name] = value;
+	}
+
+	//**********************************
+	// Assemble some source
+	//**********************************
+	void Assembler::assemble(std::string_view source)
+	{
+		line = 0;
+		ended = false;
+		try
+		{
+			size_t pos = 0;
+			while (pos <= source.size() && !ended)
+			{
+				size_t end = source.find('\n', pos);
+				if (end == std::string_view::npos) end = source.size();
+				++line;
+				statement(source.substr(pos, end - pos));
+				pos = end + 1;
+			}
+
+			// everything is defined now, so anything still
+			// unknown never will be
+			for (const Fixup& fixup : fixups)
+			{
+				line = fixup.line;
+				int32_t value;
+				if (!evaluate(fixup.expression, fixup.here, value)) throw -1;
+				store(fixup.address, value, fixup.size);
+			}
+			fixups.clear();
+		}
+		catch (int)
+		{
+			error_line = line;
+			fixups.clear();
+			throw;
+		}
+	}
+
+	//**********************************
+	// Forget everything
+	//**********************************
+	void Assembler::reset() noexcept
+	{
+		if (high > low) std::fill(image.begin() + low, image.begin() + high, 0);
+		low = UINT32_MAX;
+		high = 0;
+		here = 0;
+		start = 0;
+		has_entry = false;
+		entry = 0;
+		symbols.clear();
+		fixups.clear();
+		line = 0;
+		error_line = 0;
+		ended = false;
+	}
+
+	//**********************************
+	// Look up a symbol
+	//**********************************
+	bool Assembler::find(const std::string& name, uint16_t& value) const
+	{
+		auto symbol = symbols.find(name);
+		if (symbol == symbols.end()) return false;
+		value = symbol->second;
+		return true;
+	}
+
+	//**********************************
+	// Copy the image out
+	//**********************************
+	size_t Assembler::copy(uint8_t* buffer, size_t capacity) const noexcept
+	{
+		size_t count = std::min<size_t>(capacity, get_size());
+		std::copy_n(get_image(), count, buffer);
+		return count;
+	}
+
+	//**********************************
+	// Load the image into a CPU
+	//**********************************
+	void Assembler::load(i8080& cpu) const noexcept
+	{
+		if (get_size()) cpu.load(get_origin(), get_image(), get_size());
+	}
+
+	//**********************************
+	// Export the symbols
+	//**********************************
+	void Assembler::export_symbols(SymbolTable& table) const
+	{
+		for (const auto& symbol : symbols)
+			table.add(symbol.first, symbol.second);
+	}
+
+	//**********************************
+	// Assemble a single line
+	//**********************************
+	void Assembler::statement(std::string_view text)
+	{
+		// cut the comment off, minding semicolons in quotes
+		char quote = 0;
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (quote)
+			{
+				if (text[i] == quote) quote = 0;
+			}
+			else if (text[i] == '\'' || text[i] == '"')
+				quote = text[i];
+			else if (text[i] == ';')
+			{
+				text = text.substr(0, i);
+				break;
+			}
+		}
+		text = trim(text);
+		start = here;
+
+		size_t length = name_length(text);
+		if (length && length < text.size() && text[length] == ':')
+		{
+			label(text.substr(0, length), static_cast<uint16_t>(here));
+			text = trim(text.substr(length + 1));
+			length = name_length(text);
+		}
+		if (text.empty()) return;
+		if (!length) throw -1;
+
+		std::string_view word = text.substr(0, length);
+		std::string_view rest = trim(text.substr(length));
+
+		// name EQU expression
+		size_t second = name_length(rest);
+		if (second && keyword(rest.substr(0, second), "EQU"))
+		{
+			label(word, static_cast<uint16_t>(require(rest.substr(second))));
+			return;
+		}
+
+		std::string_view operands[max_operands];
+		size_t count = split(rest, operands, max_operands);
+
+		if (keyword(word, "ORG"))
+		{
+			if (count != 1) throw -1;
+			int32_t address = require(operands[0]);
+			if (address < 0 || address > 0xFFFF) throw -1;
+			here = static_cast<uint32_t>(address);
+			return;
+		}
+		if (keyword(word, "DB"))
+		{
+			if (!count) throw -1;
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::string_view item = operands[i];
+				// an item that is one quoted token is a string, laid out
+				// byte by byte, except single quoted characters; anything
+				// else (like 'A'+1 or 'a'+'b') is an expression
+				char quote = item.empty() ? 0 : item[0];
+				bool quoted = (quote == '"' || quote == '\'') && item.size() >= 2 && item.find(quote, 1) == item.size() - 1;
+				bool string = quoted && !(quote == '\'' && item.size() == 3);
+				if (string)
+				{
+					for (char c : item.substr(1, item.size() - 2))
+						emit8(static_cast<uint8_t>(c));
+				}
+				else
+					emit(item, 1);
+			}
+			return;
+		}
+		if (keyword(word, "DW"))
+		{
+			if (!count) throw -1;
+			for (size_t i = 0; i < count; ++i)
+				emit(operands[i], 2);
+			return;
+		}
+		if (keyword(word, "DS"))
+		{
+			if (count != 1) throw -1;
+			int32_t size = require(operands[0]);
+			if (size < 0 || here + size > 0x10000) throw -1;
+			for (int32_t i = 0; i < size; ++i) emit8(0);
+			return;
+		}
+		if (keyword(word, "END"))
+		{
+			if (count > 1) throw -1;
+			if (count)
+			{
+				has_entry = true;
+				entry = static_cast<uint16_t>(require(operands[0]));
+			}
+			ended = true;
+			return;
+		}
+
+		// anything else is an instruction
+		key.clear();
+		for (char c : word) key += upper(c);
+		const OpcodeIndex& index = opcode_index();
+		auto shape = index.shapes.find(key);
+		if (shape == index.shapes.end()) throw -1;
+
+		size_t registers = shape->second.registers;
+		bool immediate = shape->second.format != OperandFormat::None;
+		if (count != registers + immediate) throw -1;
+
+		if (key == "RST")
+		{
+			// RST's number is an expression that picks the opcode
+			int32_t vector = require(operands[0]);
+			if (vector < 0 || vector > 7) throw -1;
+			key += ' ';
+			key += static_cast<char>('0' + vector);
+		}
+		else
+		{
+			for (size_t i = 0; i < registers; ++i)
+			{
+				key += i ? ',' : ' ';
+				for (char c : operands[i]) key += upper(c);
+			}
+		}
+
+		auto opcode = index.opcodes.find(key);
+		if (opcode == index.opcodes.end()) throw -1;
+		emit8(opcode->second);
+		if (immediate)
+			emit(operands[registers], shape->second.format == OperandFormat::Byte ? 1 : 2);
+	}
+
+	//**********************************
+	// Emit an expression
+	//**********************************
+	void Assembler::emit(std::string_view expression, uint8_t size)
+	{
+		uint16_t address = static_cast<uint16_t>(here);
+		for (uint8_t i = 0; i < size; ++i) emit8(0);
+
+		int32_t value;
+		if (evaluate(expression, static_cast<uint16_t>(start), value))
+			store(address, value, size);
+		else
+			fixups.push_back(Fixup{ address, static_cast<uint16_t>(start), size, line, std::string(expression) });
+	}
+
+	//**********************************
+	// Emit a byte
+	//**********************************
+	void Assembler::emit8(uint8_t value)
+	{
+		if (here > 0xFFFF) throw -1;
+		image[here] = value;
+		low = std::min(low, here);
+		high = std::max(high, here + 1);
+		++here;
+	}
+
+	//**********************************
+	// Evaluate an expression
+	//**********************************
+	bool Assembler::evaluate(std::string_view expression, uint16_t location, int32_t& value)
+	{
+		Expression parser{ symbols, name, expression, location };
+		value = static_cast<int32_t>(parser.bitwise_or());
+		if (parser.peek()) throw -1;
+		return parser.known;
+	}
+
+	//**********************************
+	// Evaluate an expression right now
+	//**********************************
+	int32_t Assembler::require(std::string_view expression)
+	{
+		int32_t value;
+		if (!evaluate(expression, static_cast<uint16_t>(start), value)) throw -1;
+		return value;
+	}
+
+	//**********************************
+	// Store a value
+	//**********************************
+	void Assembler::store(uint16_t address, int32_t value, uint8_t size)
+	{
+		if (size == 1)
+		{
+			if (value < -0x80 || value > 0xFF) throw -1;
+			image[address] = static_cast<uint8_t>(value);
+		}
+		else
+		{
+			if (value < -0x8000 || value > 0xFFFF) throw -1;
+			image[address] = static_cast<uint8_t>(value);
+			image[(address + 1) & 0xFFFF] = static_cast<uint8_t>(value >> 8);
+		}
+	}
+
+	//**********************************
+	// Define a label
+	//**********************************
+	void Assembler::label(std::string_view text, uint16_t value)
+	{
+		name.assign(text);
+		if (!symbols.emplace(name, value).second) throw -1;
+	}
+}
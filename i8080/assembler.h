@@ -0,0 +1,197 @@
+//**************************************
+// assembler.h
+//
+// Holds the declaration of the 8080
+// assembler, which turns source text
+// into machine code in one pass over
+// the text, using the same mnemonic
+// table as the disassembler
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace i8080
+{
+	class i8080;
+	class SymbolTable;
+
+	class Assembler final
+	{
+	public:
+		//******************************
+		// Constructor
+		//******************************
+		Assembler();
+
+		//******************************
+		// Define a symbol before
+		// assembling, so one source can
+		// be built with many parameters
+		//******************************
+		void define(const std::string& name, uint16_t value);
+
+		//******************************
+		// Assemble source text, one
+		// statement per line:
+		//   label: MNEMONIC operands ; comment
+		//   name EQU expression
+		// with ORG, DB, DW, DS and END,
+		// and expressions over numbers
+		// (12, 0x1F, 1FH, 101B), 'c',
+		// $, symbols, parentheses and
+		// + - * / % & | ^ ~ << >>
+		//
+		// Labels may be used before they
+		// are defined anywhere in the
+		// same call. Calling it again
+		// carries on from where the
+		// last call stopped
+		//
+		// Throws -1 on an error, and
+		// get_error_line says where
+		//******************************
+		void assemble(std::string_view source);
+
+		//******************************
+		// Forget all output and symbols
+		// while keeping the memory
+		// they used
+		//******************************
+		void reset() noexcept;
+
+		//******************************
+		// Get the assembled image, from
+		// the lowest address written to
+		// one past the highest
+		//******************************
+		inline const uint8_t* get_image() const noexcept { return image.data() + get_origin(); }
+		inline uint32_t get_size() const noexcept { return high > low ? high - low : 0; }
+		inline uint16_t get_origin() const noexcept { return high > low ? static_cast<uint16_t>(low) : 0; }
+
+		//******************************
+		// Get where to start running:
+		// END's operand when it had one,
+		// otherwise the first address
+		// anything was assembled at
+		//******************************
+		inline uint16_t get_entry() const noexcept { return has_entry ? entry : get_origin(); }
+
+		//******************************
+		// Get the line of the last error
+		//******************************
+		inline uint32_t get_error_line() const noexcept { return error_line; }
+
+		//******************************
+		// Look up a symbol's value
+		//******************************
+		bool find(const std::string& name, uint16_t& value) const;
+
+		//******************************
+		// Copy the image into a buffer,
+		// returning how much was copied
+		//******************************
+		size_t copy(uint8_t* buffer, size_t capacity) const noexcept;
+
+		//******************************
+		// Write the image into a CPU's
+		// memory at its origin
+		//******************************
+		void load(i8080& cpu) const noexcept;
+
+		//******************************
+		// Add every label and EQU to a
+		// symbol table, for listings and
+		// traces
+		//******************************
+		void export_symbols(SymbolTable& table) const;
+
+	private:
+		// a value that couldn't be worked out until
+		// the end of the source
+		struct Fixup
+		{
+			uint16_t address;
+			uint16_t here;
+			uint8_t size;
+			uint32_t line;
+			std::string expression;
+		};
+
+		// what a statement's operands were split into
+		static const size_t max_operands = 32;
+
+		//******************************
+		// Assemble a single line
+		//******************************
+		void statement(std::string_view line);
+
+		//******************************
+		// Emit a byte or a word holding
+		// an expression, deferring it
+		// when it uses a symbol that
+		// hasn't been defined yet
+		//******************************
+		void emit(std::string_view expression, uint8_t size);
+
+		//******************************
+		// Emit a known byte
+		//******************************
+		void emit8(uint8_t value);
+
+		//******************************
+		// Evaluate an expression with $
+		// at location, which returns
+		// false if it uses an undefined
+		// symbol
+		//******************************
+		bool evaluate(std::string_view expression, uint16_t location, int32_t& value);
+
+		//******************************
+		// Evaluate an expression that
+		// has to be known right now
+		//******************************
+		int32_t require(std::string_view expression);
+
+		//******************************
+		// Store a value checked against
+		// its size
+		//******************************
+		void store(uint16_t address, int32_t value, uint8_t size);
+
+		//******************************
+		// Define a label or EQU
+		//******************************
+		void label(std::string_view name, uint16_t value);
+
+		// the whole address space, so ORG can jump around
+		std::vector<uint8_t> image;
+		uint32_t low = UINT32_MAX;
+		uint32_t high = 0;
+
+		// the address being assembled at, and where
+		// the current statement started, which is $
+		uint32_t here = 0;
+		uint32_t start = 0;
+		bool has_entry = false;
+		uint16_t entry = 0;
+
+		std::unordered_map<std::string, uint16_t> symbols;
+		std::vector<Fixup> fixups;
+
+		// reused for lookups so they don't allocate
+		std::string key;
+		std::string name;
+
+		uint32_t line = 0;
+		uint32_t error_line = 0;
+		bool ended = false;
+	};
+}
@@ -0,0 +1,262 @@
+//**************************************
+// code_graph.cpp
+//
+// Holds the definition of the recursive
+// disassembler, which follows control
+// flow from the entry points to split an
+// image into code and data and build a
+// graph of its basic blocks
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "code_graph.h"
+
+#include <algorithm>
+
+#include "disassembler.h"
+#include "opcodes.h"
+
+namespace i8080
+{
+	//**********************************
+	// Get how an opcode leaves a block,
+	// Fall meaning it doesn't
+	//**********************************
+	static BlockExit exit_of(uint8_t op) noexcept
+	{
+		if (op == 0xC3 || op == 0xCB) return BlockExit::Jump;
+		if ((op & 0xC7) == 0xC2) return BlockExit::Branch;
+		if (op == 0xCD || op == 0xDD || op == 0xED || op == 0xFD || (op & 0xC7) == 0xC4 || (op & 0xC7) == 0xC7)
+			return BlockExit::Call;
+		if (op == 0xC9 || op == 0xD9) return BlockExit::Return;
+		if ((op & 0xC7) == 0xC0) return BlockExit::ConditionalReturn;
+		if (op == 0xE9) return BlockExit::Indirect;
+		if (op == 0x76) return BlockExit::Stop;
+		return BlockExit::Fall;
+	}
+
+	//**********************************
+	// Constructor
+	//**********************************
+	CodeGraph::CodeGraph(const uint8_t* image, size_t size, uint16_t base)
+		: image(image), size(std::min<size_t>(size, 0x10000 - base)), base(base), flags(this->size)
+	{
+	}
+
+	//**********************************
+	// Add an entry point
+	//**********************************
+	void CodeGraph::add_entry(uint16_t address)
+	{
+		add_leader(address);
+	}
+
+	//**********************************
+	// Add the usual entry points
+	//**********************************
+	void CodeGraph::add_default_entries()
+	{
+		add_entry(base);
+		for (uint32_t vector = 0; vector < 0x40; vector += 8)
+			if (inside(vector)) add_entry(static_cast<uint16_t>(vector));
+	}
+
+	//**********************************
+	// Queue a block start
+	//**********************************
+	void CodeGraph::add_leader(uint16_t address)
+	{
+		if (!inside(address)) return;
+		uint8_t& flag = flags[address - base];
+		if (flag & flag_leader) return;
+		flag |= flag_leader;
+		worklist.push_back(address);
+	}
+
+	//**********************************
+	// Trace from an address
+	//**********************************
+	void CodeGraph::trace(uint16_t address)
+	{
+		uint32_t pc = address;
+		while (inside(pc))
+		{
+			// already traced from here, by an earlier path
+			if (flags[pc - base] & flag_start) return;
+
+			uint8_t op = image[pc - base];
+			uint8_t length = opcodes[op].len;
+			if (pc - base + length > size) return;
+
+			flags[pc - base] |= flag_start;
+			for (uint8_t i = 0; i < length; ++i) flags[pc - base + i] |= flag_code;
+
+			uint16_t target = length == 3 ? image[pc - base + 1] | (image[pc - base + 2] << 8) : 0;
+			uint32_t next = pc + length;
+			switch (exit_of(op))
+			{
+			case BlockExit::Fall:
+				pc = next;
+				continue;
+			case BlockExit::Jump:
+				add_leader(target);
+				return;
+			case BlockExit::Branch:
+				add_leader(target);
+				if (next <= 0xFFFF) add_leader(static_cast<uint16_t>(next));
+				return;
+			case BlockExit::Call:
+				// RST carries its target in the opcode
+				if (length == 1) target = op & 0x38;
+				add_leader(target);
+				if (next <= 0xFFFF) add_leader(static_cast<uint16_t>(next));
+				return;
+			case BlockExit::ConditionalReturn:
+				if (next <= 0xFFFF) add_leader(static_cast<uint16_t>(next));
+				return;
+			default:
+				return;
+			}
+		}
+	}
+
+	//**********************************
+	// Follow control flow
+	//**********************************
+	void CodeGraph::analyse()
+	{
+		// an explicit worklist keeps deep call chains off the host stack
+		while (!worklist.empty())
+		{
+			uint16_t address = worklist.back();
+			worklist.pop_back();
+			trace(address);
+		}
+		build();
+	}
+
+	//**********************************
+	// Build blocks and regions
+	//**********************************
+	void CodeGraph::build()
+	{
+		blocks.clear();
+		regions.clear();
+
+		BasicBlock* block = nullptr;
+		for (size_t offset = 0; offset < size; ++offset)
+		{
+			uint8_t flag = flags[offset];
+			bool code = (flag & flag_code) != 0;
+			if (regions.empty() || regions.back().code != code)
+				regions.push_back(Region{ static_cast<uint16_t>(base + offset), static_cast<uint32_t>(base + offset), code });
+			regions.back().end = static_cast<uint32_t>(base + offset + 1);
+
+			if (!(flag & flag_start))
+			{
+				// data (or the inside of an instruction) ends any open
+				// block that doesn't reach this far
+				if (!code) block = nullptr;
+				continue;
+			}
+
+			// a new block starts at every leader and after anything
+			// that left the last one
+			uint8_t op = image[offset];
+			if (!block || (flag & flag_leader) || block->end() != base + offset)
+			{
+				blocks.push_back(BasicBlock{ static_cast<uint16_t>(base + offset), 0, 0, BlockExit::Fall, 0 });
+				block = &blocks.back();
+			}
+			block->length += opcodes[op].len;
+			++block->instructions;
+
+			BlockExit exit = exit_of(op);
+			if (exit == BlockExit::Fall && offset + opcodes[op].len < size) continue;
+			if (exit == BlockExit::Fall) exit = BlockExit::Stop;
+			block->exit = exit;
+			if (opcodes[op].len == 3) block->target = image[offset + 1] | (image[offset + 2] << 8);
+			else if (exit == BlockExit::Call) block->target = op & 0x38;
+			block = nullptr;
+		}
+	}
+
+	//**********************************
+	// Find the block holding an address
+	//**********************************
+	const BasicBlock* CodeGraph::find_block(uint16_t address) const noexcept
+	{
+		auto found = std::upper_bound(blocks.begin(), blocks.end(), address,
+			[](uint16_t address, const BasicBlock& block) { return address < block.start; });
+		if (found == blocks.begin()) return nullptr;
+		--found;
+		return address < found->end() ? &*found : nullptr;
+	}
+
+	//**********************************
+	// Check whether an address is code
+	//**********************************
+	bool CodeGraph::is_code(uint16_t address) const noexcept
+	{
+		auto found = std::upper_bound(regions.begin(), regions.end(), address,
+			[](uint16_t address, const Region& region) { return address < region.start; });
+		if (found == regions.begin()) return false;
+		--found;
+		return found->code && address < found->end;
+	}
+
+	//**********************************
+	// Write the listing
+	//**********************************
+	void CodeGraph::write_listing(std::ostream& out) const
+	{
+		static const char digits[] = "0123456789abcdef";
+		char line[Disassembler::max_line + 64];
+
+		for (const Region& region : regions)
+		{
+			uint32_t address = region.start;
+			while (address < region.end)
+			{
+				size_t offset = address - base;
+				Instruction instruction;
+				if (region.code && (flags[offset] & flag_start)
+					&& Disassembler::DecodeInstruction(image + offset, size - offset, static_cast<uint16_t>(address), instruction))
+				{
+					if (flags[offset] & flag_leader) out << "\n";
+					out.write(line, Disassembler::FormatInstruction(instruction, line));
+					out << "\n";
+					address += instruction.length;
+					continue;
+				}
+
+				// everything else (including bytes jumped into the
+				// middle of) goes out up to 8 at a time
+				size_t count = 1;
+				while (count < 8 && address + count < region.end && !(flags[offset + count] & flag_start)) ++count;
+				char* cursor = line;
+				*cursor++ = '0';
+				*cursor++ = 'x';
+				for (int shift = 12; shift >= 0; shift -= 4) *cursor++ = digits[(address >> shift) & 0xF];
+				cursor = std::copy_n("  DB      ", 10, cursor);
+				for (size_t i = 0; i < count; ++i)
+				{
+					uint8_t byte = image[offset + i];
+					if (i)
+					{
+						*cursor++ = ',';
+						*cursor++ = ' ';
+					}
+					*cursor++ = '0';
+					*cursor++ = 'x';
+					*cursor++ = digits[byte >> 4];
+					*cursor++ = digits[byte & 0xF];
+				}
+				out.write(line, cursor - line);
+				out << "\n";
+				address += static_cast<uint32_t>(count);
+			}
+		}
+	}
+}
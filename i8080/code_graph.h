@@ -0,0 +1,191 @@
+//**************************************
+// code_graph.h
+//
+// Holds the declaration of the recursive
+// disassembler, which follows control
+// flow from the entry points to split an
+// image into code and data and build a
+// graph of its basic blocks
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace i8080
+{
+	// how control leaves a basic block
+	enum class BlockExit : uint8_t
+	{
+		// runs into the next block (which starts at a jump target)
+		Fall,
+		// JMP to target
+		Jump,
+		// Jcc to target, or on into the next block
+		Branch,
+		// CALL, Ccc or RST to target, then on into the next block
+		Call,
+		// RET, with nowhere known to go
+		Return,
+		// Rcc, or on into the next block
+		ConditionalReturn,
+		// PCHL, to wherever HL points
+		Indirect,
+		// HLT, or decoding ran off the image
+		Stop
+	};
+
+	// a run of instructions only entered at the top
+	struct BasicBlock
+	{
+		uint16_t start;
+		// in bytes, the last instruction included
+		uint16_t length;
+		uint16_t instructions;
+		BlockExit exit;
+		// where a Jump, Branch or Call goes
+		uint16_t target;
+
+		//******************************
+		// Get whether control can carry
+		// on into the next block
+		//******************************
+		inline bool falls_through() const noexcept
+		{
+			return exit == BlockExit::Fall || exit == BlockExit::Branch
+				|| exit == BlockExit::Call || exit == BlockExit::ConditionalReturn;
+		}
+
+		//******************************
+		// Get the address just past the
+		// block
+		//******************************
+		inline uint32_t end() const noexcept { return static_cast<uint32_t>(start) + length; }
+	};
+
+	// a run of bytes that are all code or all data
+	struct Region
+	{
+		uint16_t start;
+		uint32_t end;
+		bool code;
+	};
+
+	class CodeGraph final
+	{
+	public:
+		//******************************
+		// Constructor, takes the image
+		// and the address it loads at
+		//
+		// Nothing is decoded until
+		// analyse() is called
+		//******************************
+		CodeGraph(const uint8_t* image, size_t size, uint16_t base = 0);
+
+		//******************************
+		// Add an address execution can
+		// start from
+		//******************************
+		void add_entry(uint16_t address);
+
+		//******************************
+		// Add the start of the image and
+		// any RST vectors inside it
+		//******************************
+		void add_default_entries();
+
+		//******************************
+		// Follow control flow from every
+		// entry and build the blocks and
+		// code/data regions
+		//******************************
+		void analyse();
+
+		//******************************
+		// Get the blocks, in address
+		// order
+		//******************************
+		inline const std::vector<BasicBlock>& get_blocks() const noexcept { return blocks; }
+
+		//******************************
+		// Get the code and data regions
+		// covering the whole image, in
+		// address order
+		//******************************
+		inline const std::vector<Region>& get_regions() const noexcept { return regions; }
+
+		//******************************
+		// Get the block containing an
+		// address
+		//
+		// Returns null when the address
+		// isn't in any block
+		//******************************
+		const BasicBlock* find_block(uint16_t address) const noexcept;
+
+		//******************************
+		// Get whether an address was
+		// reached as code
+		//******************************
+		bool is_code(uint16_t address) const noexcept;
+
+		//******************************
+		// Get whether an instruction
+		// starts at an address
+		//******************************
+		inline bool is_instruction(uint16_t address) const noexcept
+		{
+			return inside(address) && (flags[address - base] & flag_start);
+		}
+
+		//******************************
+		// Write a listing that decodes
+		// the code and shows the data
+		// as DB lines
+		//******************************
+		void write_listing(std::ostream& out) const;
+	private:
+		// per-byte flags filled in while tracing
+		static const uint8_t flag_start = 1 << 0;
+		static const uint8_t flag_code = 1 << 1;
+		static const uint8_t flag_leader = 1 << 2;
+
+		const uint8_t* image;
+		size_t size;
+		uint16_t base;
+
+		std::vector<uint8_t> flags;
+		std::vector<uint16_t> worklist;
+		std::vector<BasicBlock> blocks;
+		std::vector<Region> regions;
+
+		//******************************
+		// Get whether an address is in
+		// the image
+		//******************************
+		inline bool inside(uint32_t address) const noexcept { return address >= base && address - base < size; }
+
+		//******************************
+		// Queue a block start
+		//******************************
+		void add_leader(uint16_t address);
+
+		//******************************
+		// Decode from an address until
+		// control leaves or it meets
+		// code already traced
+		//******************************
+		void trace(uint16_t address);
+
+		//******************************
+		// Cut the traced code into
+		// blocks and regions
+		//******************************
+		void build();
+	};
+}
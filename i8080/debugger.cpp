@@ -0,0 +1,98 @@
+//**************************************
+// debugger.cpp
+//
+// Holds the definition of the set of
+// breakpoints and watchpoints the CPU
+// stops at, kept as bitmaps with a
+// count per page so most addresses are
+// ruled out with a single lookup
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "debugger.h"
+
+namespace i8080
+{
+	//**********************************
+	// Add a breakpoint
+	//**********************************
+	void Debugger::add_breakpoint(uint16_t address) noexcept
+	{
+		set(breaks, break_pages, address);
+	}
+
+	//**********************************
+	// Remove a breakpoint
+	//**********************************
+	void Debugger::remove_breakpoint(uint16_t address) noexcept
+	{
+		reset(breaks, break_pages, address);
+	}
+
+	//**********************************
+	// Add a watchpoint
+	//**********************************
+	void Debugger::add_watchpoint(uint16_t address, uint32_t length, uint8_t kinds) noexcept
+	{
+		if (length > 0x10000) length = 0x10000;
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			uint16_t at = static_cast<uint16_t>(address + i);
+			if ((kinds & watch_read) && set(reads, read_pages, at)) ++watched;
+			if ((kinds & watch_write) && set(writes, write_pages, at)) ++watched;
+		}
+	}
+
+	//**********************************
+	// Remove a watchpoint
+	//**********************************
+	void Debugger::remove_watchpoint(uint16_t address, uint32_t length, uint8_t kinds) noexcept
+	{
+		if (length > 0x10000) length = 0x10000;
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			uint16_t at = static_cast<uint16_t>(address + i);
+			if ((kinds & watch_read) && reset(reads, read_pages, at)) --watched;
+			if ((kinds & watch_write) && reset(writes, write_pages, at)) --watched;
+		}
+	}
+
+	//**********************************
+	// Remove everything
+	//**********************************
+	void Debugger::clear() noexcept
+	{
+		breaks.fill(0);
+		reads.fill(0);
+		writes.fill(0);
+		break_pages.fill(0);
+		read_pages.fill(0);
+		write_pages.fill(0);
+		watched = 0;
+	}
+
+	//**********************************
+	// Set a bit, returning whether it
+	// was clear before
+	//**********************************
+	bool Debugger::set(Bits& bits, std::array<uint16_t, 256>& pages, uint16_t address) noexcept
+	{
+		if (test(bits, address)) return false;
+		bits[address >> 6] |= uint64_t(1) << (address & 63);
+		++pages[address >> 8];
+		return true;
+	}
+
+	//**********************************
+	// Clear a bit, returning whether it
+	// was set before
+	//**********************************
+	bool Debugger::reset(Bits& bits, std::array<uint16_t, 256>& pages, uint16_t address) noexcept
+	{
+		if (!test(bits, address)) return false;
+		bits[address >> 6] &= ~(uint64_t(1) << (address & 63));
+		--pages[address >> 8];
+		return true;
+	}
+}
@@ -0,0 +1,144 @@
+//**************************************
+// debugger.h
+//
+// Holds the declaration of the set of
+// breakpoints and watchpoints the CPU
+// stops at, kept as bitmaps with a
+// count per page so most addresses are
+// ruled out with a single lookup
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace i8080
+{
+	class Debugger final
+	{
+	public:
+		// the accesses a watchpoint stops on
+		enum Watch : uint8_t
+		{
+			watch_read = 1 << 0,
+			watch_write = 1 << 1,
+			watch_access = watch_read | watch_write
+		};
+
+		// why the CPU last stopped
+		enum class Stop : uint8_t
+		{
+			None,
+			// before running the instruction at the breakpoint
+			Breakpoint,
+			// after running an instruction that touched a watchpoint
+			Read,
+			Write
+		};
+
+		//******************************
+		// Stop before the instruction
+		// at address runs
+		//******************************
+		void add_breakpoint(uint16_t address) noexcept;
+		void remove_breakpoint(uint16_t address) noexcept;
+
+		//******************************
+		// Stop after an instruction
+		// reads or writes any of the
+		// length bytes from address
+		//******************************
+		void add_watchpoint(uint16_t address, uint32_t length = 1, uint8_t kinds = watch_access) noexcept;
+		void remove_watchpoint(uint16_t address, uint32_t length = 1, uint8_t kinds = watch_access) noexcept;
+
+		//******************************
+		// Remove every breakpoint and
+		// watchpoint
+		//******************************
+		void clear() noexcept;
+
+		//******************************
+		// Check for a breakpoint, which
+		// only looks at the bitmap when
+		// the page has any
+		//******************************
+		inline bool is_breakpoint(uint16_t address) const noexcept { return break_pages[address >> 8] && test(breaks, address); }
+
+		//******************************
+		// Check for a watchpoint on one
+		// kind of access
+		//******************************
+		inline bool is_watched(uint16_t address, Watch kind) const noexcept
+		{
+			if (kind == watch_read) return read_pages[address >> 8] && test(reads, address);
+			return write_pages[address >> 8] && test(writes, address);
+		}
+
+		//******************************
+		// Check whether any watchpoints
+		// are set, so the CPU can skip
+		// working out what an
+		// instruction touched
+		//******************************
+		inline bool has_watchpoints() const noexcept { return watched != 0; }
+
+		//******************************
+		// Record why the CPU stopped,
+		// keeping the first reason when
+		// there are several
+		//******************************
+		inline void stop(Stop reason, uint16_t pc, uint16_t address) noexcept
+		{
+			if (stopped != Stop::None) return;
+			stopped = reason;
+			stop_pc = pc;
+			stop_address = address;
+		}
+
+		//******************************
+		// Forget why the CPU stopped,
+		// which it does itself at the
+		// start of every run
+		//******************************
+		inline void resume() noexcept { stopped = Stop::None; }
+
+		//******************************
+		// Get why the CPU last stopped,
+		// the address of the instruction
+		// and the address it touched
+		//******************************
+		inline Stop get_stop() const noexcept { return stopped; }
+		inline uint16_t get_stop_pc() const noexcept { return stop_pc; }
+		inline uint16_t get_stop_address() const noexcept { return stop_address; }
+	private:
+		// one bit per address
+		using Bits = std::array<uint64_t, 0x10000 / 64>;
+
+		//******************************
+		// Test, set or clear one bit,
+		// keeping its page's count
+		//******************************
+		static inline bool test(const Bits& bits, uint16_t address) noexcept { return (bits[address >> 6] >> (address & 63)) & 1; }
+		static bool set(Bits& bits, std::array<uint16_t, 256>& pages, uint16_t address) noexcept;
+		static bool reset(Bits& bits, std::array<uint16_t, 256>& pages, uint16_t address) noexcept;
+
+		Bits breaks{};
+		Bits reads{};
+		Bits writes{};
+
+		// how many bits are set in each 256 byte page
+		std::array<uint16_t, 256> break_pages{};
+		std::array<uint16_t, 256> read_pages{};
+		std::array<uint16_t, 256> write_pages{};
+
+		// how many watch bits are set in all
+		uint32_t watched = 0;
+
+		Stop stopped = Stop::None;
+		uint16_t stop_pc = 0;
+		uint16_t stop_address = 0;
+	};
+}
@@ -10,8 +10,8 @@
 //**************************************
 #include "disassembler.h"
 
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+
 #include "mnemonics.h"
 #include "opcodes.h"
 
@@ -27,61 +27,111 @@ namespace i8080
 
 	string Disassembler::GetLine()
 	{
-		string ret = "";
 		// read in the instruction
+		uint8_t bytes[3];
 		unsigned int _op = m_file.get();
-		if (_op > 255) return ret;
-		opcode op = opcodes[_op];
-
-		// add our base mnemonic into our return string
-		std::stringstream lineno;
-		lineno << "0x" << std::setfill('0') << std::setw(4) << std::hex << m_line << "  ";
-		lineno << std::setfill(' ') << std::setw(8) << std::left << mnemonics[_op];
-		ret = lineno.str();
-		m_line += op.len;
+		if (_op > 255) return "";
+		bytes[0] = static_cast<uint8_t>(_op);
 
-		// see what size the arguments are, if any
-		switch (op.len)
+		// pull in its operands, if any
+		for (int byte = 1; byte < opcodes[_op].len; ++byte)
 		{
-		// just the mnemonic
-		case 1:
-			return ret;
-		case 2:
-		{
-			// 8 bit address
 			if (m_file.eof()) throw -1;
-			std::stringstream str;
-			str << "0x" << std::setfill('0') << std::setw(2) << std::hex << m_file.get();
-			return ret + str.str();
+			bytes[byte] = static_cast<uint8_t>(m_file.get());
 		}
-		case 3:
+
+		string ret = Decode(m_line, bytes);
+		m_line += opcodes[_op].len;
+		return ret;
+	}
+
+	string Disassembler::Decode(uint16_t address, const uint8_t* bytes, const SymbolTable* symbols)
+	{
+		Instruction instruction;
+		DecodeInstruction(bytes, 3, address, instruction);
+		char line[max_line];
+		return string(line, FormatInstruction(instruction, line, symbols));
+	}
+
+	bool Disassembler::DecodeInstruction(const uint8_t* bytes, size_t size, uint16_t address, Instruction& out) noexcept
+	{
+		if (size == 0) return false;
+		out.address = address;
+		out.opcode = bytes[0];
+		out.length = opcodes[bytes[0]].len;
+		out.operand = 0;
+		if (out.length > size) return false;
+		if (out.length == 2) out.operand = bytes[1];
+		else if (out.length == 3) out.operand = bytes[1] | (bytes[2] << 8);
+		return true;
+	}
+
+	//**********************************
+	// Write value as count hex digits
+	//**********************************
+	static inline char* write_hex(char* out, uint16_t value, int count) noexcept
+	{
+		static const char digits[] = "0123456789abcdef";
+		*out++ = '0';
+		*out++ = 'x';
+		for (int shift = (count - 1) * 4; shift >= 0; shift -= 4)
+			*out++ = digits[(value >> shift) & 0xF];
+		return out;
+	}
+
+	size_t Disassembler::FormatInstruction(const Instruction& instruction, char* buffer, const SymbolTable* symbols) noexcept
+	{
+		// laid out as "0x0100  MVI     B, 0x12", with the mnemonic
+		// padded out to at least 8 columns
+		char* out = write_hex(buffer, instruction.address, 4);
+		*out++ = ' ';
+		*out++ = ' ';
+		const MnemonicInfo& mnemonic = mnemonics[instruction.opcode];
+		char* column = out;
+		for (char c : mnemonic.name) *out++ = c;
+		while (out < column + 8) *out++ = ' ';
+		for (char c : mnemonic.operands) *out++ = c;
+		if (!mnemonic.operands.empty() && mnemonic.format != OperandFormat::None)
 		{
-			if (m_file.eof()) throw -1;
-			uint16_t addr = m_file.get();
-			if (m_file.eof()) throw - 1;
-			addr |= m_file.get() << 8;
-			std::stringstream str;
-			str << "0x" << std::setfill('0') << std::setw(4) << std::hex << addr;
-			return ret + str.str();
+			*out++ = ',';
+			*out++ = ' ';
 		}
-		default:
-			throw -1;
+
+		if (instruction.length == 2) out = write_hex(out, instruction.operand, 2);
+		else if (instruction.length == 3)
+		{
+			std::string_view symbol = symbols ? symbols->find(instruction.operand) : std::string_view();
+			if (symbol.empty()) out = write_hex(out, instruction.operand, 4);
+			else out = std::copy_n(symbol.begin(), std::min(symbol.size(), SymbolTable::max_name), out);
 		}
+		return out - buffer;
+	}
 
-		if (op.len > 1)
+	size_t Disassembler::DisassembleBuffer(const uint8_t* bytes, size_t size, uint16_t address,
+		char* buffer, size_t capacity, size_t& written) noexcept
+	{
+		size_t used = 0;
+		written = 0;
+		Instruction instruction;
+		// a line plus its newline must fit before it's started
+		while (capacity - written > max_line && DecodeInstruction(bytes + used, size - used, address, instruction))
 		{
-			ret += " ";
-			// loop through and add all of the remaining arguments
-			for (int byte = 1; byte < op.len; ++byte)
-			{
-				if (m_file.eof()) throw -1;
-				std::stringstream str;
-				if (byte != 1) str << ",";
-				str << std::hex << m_file.get();
-				ret += str.str();
-			}
+			written += FormatInstruction(instruction, buffer + written);
+			buffer[written++] = '\n';
+			used += instruction.length;
+			address += instruction.length;
 		}
+		return used;
+	}
 
+	string Disassembler::Mnemonic(uint8_t op)
+	{
+		string ret(mnemonics[op].name);
+		if (!mnemonics[op].operands.empty())
+		{
+			ret += ' ';
+			ret += mnemonics[op].operands;
+		}
 		return ret;
 	}
 }
\ No newline at end of file
@@ -10,12 +10,25 @@
 //**************************************
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <fstream>
 using std::string;
 
+#include "symbol_table.h"
+
 namespace i8080
 {
+	// a single decoded instruction
+	struct Instruction
+	{
+		uint16_t address;
+		uint8_t opcode;
+		// the immediate byte or word, zero when there is none
+		uint16_t operand;
+		uint8_t length;
+	};
+
 	class Disassembler final
 	{
 	public:
@@ -48,6 +61,65 @@ namespace i8080
 		// any contents left in it
 		//******************************
 		inline bool HasContent() noexcept { return !m_file.eof(); }
+
+		//******************************
+		// Format a single instruction
+		// that is already in memory,
+		// bytes holds the opcode and
+		// any operands after it
+		//
+		// Addresses with a symbol are
+		// shown by name
+		//******************************
+		static string Decode(uint16_t address, const uint8_t* bytes, const SymbolTable* symbols = nullptr);
+
+		//******************************
+		// Decode the instruction at the
+		// start of bytes, which has size
+		// bytes left in it
+		//
+		// Returns false when the
+		// instruction runs past the end
+		//******************************
+		static bool DecodeInstruction(const uint8_t* bytes, size_t size, uint16_t address, Instruction& out) noexcept;
+
+		//******************************
+		// Format an instruction into a
+		// buffer of at least max_line
+		// characters, without a newline
+		// or terminator
+		//
+		// A 16 bit operand with a symbol
+		// is shown by name
+		//
+		// Returns the characters written
+		//******************************
+		static size_t FormatInstruction(const Instruction& instruction, char* buffer, const SymbolTable* symbols = nullptr) noexcept;
+
+		//******************************
+		// Disassemble as many whole
+		// lines as fit in buffer, each
+		// ending in a newline
+		//
+		// Returns how many input bytes
+		// were used and sets written to
+		// how many characters were
+		// written; stops early at an
+		// instruction cut off by the end
+		// of the input
+		//******************************
+		static size_t DisassembleBuffer(const uint8_t* bytes, size_t size, uint16_t address,
+			char* buffer, size_t capacity, size_t& written) noexcept;
+
+		// the longest line FormatInstruction writes
+		static const size_t max_line = 32 + SymbolTable::max_name;
+
+		//******************************
+		// Get the mnemonic for an opcode
+		// with its register operands
+		// (e.g. "MOV A,M")
+		//******************************
+		static string Mnemonic(uint8_t op);
 	private:
 		std::ifstream m_file;
 		uint16_t m_line;
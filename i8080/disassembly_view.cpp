@@ -0,0 +1,151 @@
+//**************************************
+// disassembly_view.cpp
+//
+// Holds the definition of the cached
+// disassembly view a debugger UI scrolls
+// through, which decodes lazily and
+// drops a page's lines when the guest
+// writes to it
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "disassembly_view.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "opcodes.h"
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	DisassemblyView::DisassemblyView(const i8080& cpu, const SymbolTable* symbols)
+		: cpu(cpu), symbols(symbols)
+	{
+	}
+
+	//**********************************
+	// Get a page, copying it if stale
+	//**********************************
+	DisassemblyView::Page& DisassemblyView::page(uint8_t number)
+	{
+		std::unique_ptr<Page>& slot = pages[number];
+		if (!slot) slot.reset(new Page());
+		Page& cached = *slot;
+
+		uint8_t next = static_cast<uint8_t>(number + 1);
+		uint32_t writes = cpu.get_page_writes(number);
+		uint32_t next_writes = cpu.get_page_writes(next);
+		if (cached.valid && cached.writes == writes && cached.next_writes == next_writes) return cached;
+
+		// copy the bytes and check the counts again afterwards; if the
+		// CPU wrote in the meantime the copy may be torn, so try again.
+		// The bytes are read with relaxed atomic loads, as a seqlock
+		// reader has to be
+		const uint8_t* memory = cpu.get_memory();
+		uint32_t size = cpu.get_memory_size();
+		bool stable = false;
+		for (int attempt = 0; attempt < 4 && !stable; ++attempt)
+		{
+			for (uint32_t i = 0; i < cached.bytes.size(); ++i)
+			{
+				uint32_t address = ((number << 8) + i) & 0xFFFF;
+				cached.bytes[i] = address < size ? load_relaxed(memory + address) : 0;
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			uint32_t after = cpu.get_page_writes(number);
+			uint32_t next_after = cpu.get_page_writes(next);
+			stable = after == writes && next_after == next_writes;
+			writes = after;
+			next_writes = next_after;
+		}
+
+		// a copy that never settled may predate writes the counts
+		// include, so it's only good for this call and the next one
+		// copies again
+		cached.writes = writes;
+		cached.next_writes = next_writes;
+		cached.valid = stable;
+		cached.formatted.reset();
+		cached.starts.reset();
+		return cached;
+	}
+
+	//**********************************
+	// Get the line at an address
+	//**********************************
+	ViewLine DisassemblyView::line(uint16_t address)
+	{
+		Page& cached = page(address >> 8);
+		uint8_t offset = address & 0xFF;
+
+		if (!cached.formatted[offset])
+		{
+			Instruction instruction;
+			Disassembler::DecodeInstruction(cached.bytes.data() + offset, cached.bytes.size() - offset, address, instruction);
+			cached.lengths[offset] = static_cast<uint8_t>(Disassembler::FormatInstruction(instruction, cached.text[offset].data(), symbols));
+			cached.formatted[offset] = true;
+		}
+		cached.starts[offset] = true;
+
+		uint8_t length = opcodes[cached.bytes[offset]].len;
+		return ViewLine{ address, length, std::string_view(cached.text[offset].data(), cached.lengths[offset]) };
+	}
+
+	//**********************************
+	// Fill lines from an address
+	//**********************************
+	size_t DisassemblyView::get_lines(uint16_t address, ViewLine* lines, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			lines[i] = line(address);
+			address += lines[i].length;
+		}
+		return count;
+	}
+
+	//**********************************
+	// Find the instruction before
+	//**********************************
+	uint16_t DisassemblyView::previous(uint16_t address)
+	{
+		// an instruction seen while scrolling down that ends right
+		// here is the answer
+		for (uint16_t back = 1; back <= 3; ++back)
+		{
+			uint16_t start = address - back;
+			Page& cached = page(start >> 8);
+			if (cached.starts[start & 0xFF] && opcodes[cached.bytes[start & 0xFF]].len == back) return start;
+		}
+
+		// otherwise sweep forward from a little way back until a
+		// sweep lands on the address; the sweeps quickly fall into
+		// step, so the furthest one that lands is the likeliest
+		for (uint16_t lead = 24; lead > 0; --lead)
+		{
+			uint16_t at = address - lead;
+			uint16_t last = at;
+			uint16_t walked = 0;
+			while (walked < lead)
+			{
+				last = at;
+				uint8_t length = opcodes[page(at >> 8).bytes[at & 0xFF]].len;
+				at += length;
+				walked += length;
+			}
+			if (walked == lead)
+			{
+				// remember the sweep so the next step back is direct
+				for (uint16_t start = address - lead; start != address; start += opcodes[page(start >> 8).bytes[start & 0xFF]].len)
+					page(start >> 8).starts[start & 0xFF] = true;
+				return last;
+			}
+		}
+		return address - 1;
+	}
+}
@@ -0,0 +1,99 @@
+//**************************************
+// disassembly_view.h
+//
+// Holds the declaration of the cached
+// disassembly view a debugger UI scrolls
+// through, which decodes lazily and
+// drops a page's lines when the guest
+// writes to it
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "disassembler.h"
+#include "i8080.h"
+#include "symbol_table.h"
+
+namespace i8080
+{
+	// one line of the view
+	struct ViewLine
+	{
+		uint16_t address;
+		uint8_t length;
+		// valid until the view is next asked for anything
+		std::string_view text;
+	};
+
+	class DisassemblyView final
+	{
+	public:
+		//******************************
+		// Constructor, takes the CPU
+		// whose memory is shown
+		//
+		// The view belongs to one thread
+		// (the UI's), but the CPU may be
+		// running on another
+		//******************************
+		DisassemblyView(const i8080& cpu, const SymbolTable* symbols = nullptr);
+
+		//******************************
+		// Fill lines with up to count
+		// instructions starting at an
+		// address
+		//
+		// Returns how many were filled
+		//******************************
+		size_t get_lines(uint16_t address, ViewLine* lines, size_t count);
+
+		//******************************
+		// Get the start of the
+		// instruction before an address,
+		// for scrolling up
+		//******************************
+		uint16_t previous(uint16_t address);
+	private:
+		// what's cached for one 256 byte page
+		struct Page
+		{
+			// the page's write count (and the next page's, since the
+			// last instructions reach into it) when it was copied
+			uint32_t writes = 0;
+			uint32_t next_writes = 0;
+			bool valid = false;
+			// the page plus the first 2 bytes of the next one
+			std::array<uint8_t, 258> bytes{};
+			// which lines have been formatted
+			std::bitset<256> formatted;
+			// instructions starts seen so far, for scrolling back
+			std::bitset<256> starts;
+			std::array<uint8_t, 256> lengths{};
+			std::array<std::array<char, Disassembler::max_line>, 256> text;
+		};
+
+		const i8080& cpu;
+		const SymbolTable* symbols;
+		std::array<std::unique_ptr<Page>, 256> pages;
+
+		//******************************
+		// Get a page, copying it again
+		// if the guest wrote to it
+		//******************************
+		Page& page(uint8_t number);
+
+		//******************************
+		// Get the line at an address,
+		// formatting it if needed
+		//******************************
+		ViewLine line(uint16_t address);
+	};
+}
@@ -0,0 +1,177 @@
+//**************************************
+// divergence.cpp
+//
+// Holds the definition of the tools
+// that find the first instruction where
+// two runs of a program stop agreeing
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "divergence.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DIVERGENCE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "disassembler.h"
+#include "lockstep.h"
+#include "trace_reader.h"
+
+namespace i8080
+{
+	//**********************************
+	// Find the first differing byte
+	//**********************************
+	size_t first_difference(const uint8_t* a, const uint8_t* b, size_t size) noexcept
+	{
+		size_t offset = 0;
+#ifdef DIVERGENCE_SSE2
+		// compare 64 bytes per pass and only look closer at the
+		// pass that contains a difference
+		for (; offset + 64 <= size; offset += 64)
+		{
+			__m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset)));
+			__m128i e1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset + 16)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset + 16)));
+			__m128i e2 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset + 32)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset + 32)));
+			__m128i e3 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset + 48)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset + 48)));
+			if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3))) != 0xFFFF) break;
+		}
+		for (; offset + 16 <= size; offset += 16)
+		{
+			__m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset)));
+			int mask = _mm_movemask_epi8(equal);
+			if (mask != 0xFFFF)
+			{
+				// the lowest clear bit is the first byte that differs
+				mask = ~mask & 0xFFFF;
+				size_t bit = 0;
+				while (!(mask & (1 << bit))) ++bit;
+				return offset + bit;
+			}
+		}
+#else
+		for (; offset + 8 <= size; offset += 8)
+		{
+			uint64_t wa, wb;
+			std::memcpy(&wa, a + offset, 8);
+			std::memcpy(&wb, b + offset, 8);
+			if (wa != wb) break;
+		}
+#endif
+		for (; offset < size; ++offset)
+			if (a[offset] != b[offset]) break;
+		return offset;
+	}
+
+	//**********************************
+	// Find where two traces diverge
+	//**********************************
+	Divergence find_divergence(const TraceReader& a, const TraceReader& b) noexcept
+	{
+		size_t count = a.size() < b.size() ? a.size() : b.size();
+
+		// walk the keyframes while both traces took them at the same
+		// records and their hashes match; everything before the last
+		// matching one is taken to be the same and never compared
+		size_t start = 0;
+		size_t keyframes = a.keyframe_count() < b.keyframe_count() ? a.keyframe_count() : b.keyframe_count();
+		for (size_t k = 0; k < keyframes; ++k)
+		{
+			const trace::Keyframe& ka = a.keyframe(k);
+			const trace::Keyframe& kb = b.keyframe(k);
+			if (ka.index != kb.index || ka.hash != kb.hash || ka.index >= count) break;
+			start = static_cast<size_t>(ka.index);
+		}
+
+		const uint8_t* ra = reinterpret_cast<const uint8_t*>(a.data() + start);
+		const uint8_t* rb = reinterpret_cast<const uint8_t*>(b.data() + start);
+		size_t index = start + first_difference(ra, rb, (count - start) * sizeof(trace::Record)) / sizeof(trace::Record);
+
+		Divergence divergence;
+		if (index == count && a.size() == b.size()) return divergence;
+
+		divergence.found = true;
+		divergence.index = index;
+		divergence.ended = index == count;
+		if (index < a.size()) divergence.a = a[index];
+		if (index < b.size()) divergence.b = b[index];
+		if (index > 0) divergence.previous = a[index - 1];
+		return divergence;
+	}
+
+	//**********************************
+	// Find where two live CPUs diverge
+	//**********************************
+	Divergence find_divergence(i8080& a, i8080& b, uint64_t max_instructions, uint64_t memory_interval)
+	{
+		Lockstep lockstep(a, b, memory_interval);
+		return lockstep.run(max_instructions);
+	}
+
+	//**********************************
+	// Describe a divergence
+	//**********************************
+	std::string describe(const Divergence& divergence)
+	{
+		std::stringstream out;
+		if (!divergence.found)
+		{
+			out << "no divergence found\n";
+			return out.str();
+		}
+
+		out << "diverged at instruction " << divergence.index << "\n";
+		if (divergence.index > 0)
+		{
+			uint8_t bytes[3] = { divergence.previous.op, divergence.previous.operands[0], divergence.previous.operands[1] };
+			out << "  after " << Disassembler::Decode(divergence.previous.pc, bytes) << "\n";
+		}
+		if (divergence.ended) out << "  one run ended before the other\n";
+		if (divergence.address >= 0)
+			out << "  memory differs from 0x" << std::hex << std::setfill('0') << std::setw(4) << divergence.address << std::dec << "\n";
+
+		const trace::Record& a = divergence.a;
+		const trace::Record& b = divergence.b;
+		if (a.op != b.op || a.operands[0] != b.operands[0] || a.operands[1] != b.operands[1])
+		{
+			uint8_t bytes_a[3] = { a.op, a.operands[0], a.operands[1] };
+			uint8_t bytes_b[3] = { b.op, b.operands[0], b.operands[1] };
+			out << "  instruction: " << Disassembler::Decode(a.pc, bytes_a) << " -> " << Disassembler::Decode(b.pc, bytes_b) << "\n";
+		}
+		out << std::hex << std::setfill('0');
+
+		// print each field that differs as a -> b
+		auto delta = [&](const char* name, unsigned int va, unsigned int vb, int width)
+		{
+			if (va != vb) out << "  " << name << ": " << std::setw(width) << va << " -> " << std::setw(width) << vb << "\n";
+		};
+		delta("PC", a.pc, b.pc, 4);
+		delta("SP", a.sp, b.sp, 4);
+		delta("A", a.A, b.A, 2);
+		delta("B", a.B, b.B, 2);
+		delta("C", a.C, b.C, 2);
+		delta("D", a.D, b.D, 2);
+		delta("E", a.E, b.E, 2);
+		delta("H", a.H, b.H, 2);
+		delta("L", a.L, b.L, 2);
+		delta("INTE", a.flags & trace::inte, b.flags & trace::inte, 1);
+
+		// and name the flags that flipped
+		const char names[8] = { 'C', '1', 'P', '3', 'A', '5', 'Z', 'S' };
+		if (a.F != b.F)
+		{
+			out << "  F: " << std::setw(2) << +a.F << " -> " << std::setw(2) << +b.F << " (";
+			for (int bit = 7; bit >= 0; --bit)
+				if ((a.F ^ b.F) & (1 << bit)) out << ((b.F >> bit) & 1 ? '+' : '-') << names[bit];
+			out << ")\n";
+		}
+		if (a.cycle != b.cycle) out << std::dec << "  cycle: " << a.cycle << " -> " << b.cycle << "\n";
+		return out.str();
+	}
+}
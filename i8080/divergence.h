@@ -0,0 +1,70 @@
+//**************************************
+// divergence.h
+//
+// Holds the declaration of the tools
+// that find the first instruction where
+// two runs of a program stop agreeing
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "trace_format.h"
+
+namespace i8080
+{
+	class i8080;
+	class TraceReader;
+
+	// where two runs stopped agreeing
+	struct Divergence
+	{
+		// false when the runs agreed as far as they were compared
+		bool found = false;
+		// the first instruction whose starting state differs
+		uint64_t index = 0;
+		// the states both runs were in at index
+		trace::Record a{};
+		trace::Record b{};
+		// the instruction both ran just before, which is the one
+		// that produced different results (only if index > 0)
+		trace::Record previous{};
+		// set when one run ended before the other
+		bool ended = false;
+		// set when only memory differs, to the first address that does
+		int32_t address = -1;
+	};
+
+	//**********************************
+	// Get the offset of the first byte
+	// that differs between a and b, or
+	// size if they are the same
+	//**********************************
+	size_t first_difference(const uint8_t* a, const uint8_t* b, size_t size) noexcept;
+
+	//**********************************
+	// Find where two binary traces
+	// diverge, skipping stretches that
+	// keyframe hashes show are the same
+	//**********************************
+	Divergence find_divergence(const TraceReader& a, const TraceReader& b) noexcept;
+
+	//**********************************
+	// Step two live CPUs together and
+	// find where they diverge, comparing
+	// memory every memory_interval
+	// instructions
+	//**********************************
+	Divergence find_divergence(i8080& a, i8080& b, uint64_t max_instructions, uint64_t memory_interval = 1 << 16);
+
+	//**********************************
+	// Describe a divergence along with
+	// its register and flag deltas
+	//**********************************
+	std::string describe(const Divergence& divergence);
+}
@@ -0,0 +1,53 @@
+//**************************************
+// heatmap.cpp
+//
+// Holds the definition of the memory
+// heatmap, which counts instruction
+// fetches, data reads and data writes
+// per byte or per page of guest memory
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "heatmap.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	Heatmap::Heatmap(unsigned shift)
+		: shift(std::min(shift, 16u)),
+		fetches(0x10000 >> this->shift),
+		reads(0x10000 >> this->shift),
+		writes(0x10000 >> this->shift)
+	{
+	}
+
+	//**********************************
+	// Zero every counter
+	//**********************************
+	void Heatmap::reset() noexcept
+	{
+		std::fill(fetches.begin(), fetches.end(), 0);
+		std::fill(reads.begin(), reads.end(), 0);
+		std::fill(writes.begin(), writes.end(), 0);
+	}
+
+	//**********************************
+	// Write the touched ranges
+	//**********************************
+	void Heatmap::write_table(std::ostream& out) const
+	{
+		out << "address fetches reads writes\n";
+		for (size_t range = 0; range < fetches.size(); ++range)
+		{
+			if (!fetches[range] && !reads[range] && !writes[range]) continue;
+			out << "0x" << std::hex << std::setfill('0') << std::setw(4) << (range << shift) << std::dec
+				<< " " << fetches[range] << " " << reads[range] << " " << writes[range] << "\n";
+		}
+	}
+}
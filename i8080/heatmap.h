@@ -0,0 +1,65 @@
+//**************************************
+// heatmap.h
+//
+// Holds the declaration of the memory
+// heatmap, which counts instruction
+// fetches, data reads and data writes
+// per byte or per page of guest memory
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace i8080
+{
+	class Heatmap final
+	{
+	public:
+		//******************************
+		// Constructor
+		//
+		// Each counter covers 1 << shift
+		// bytes, so 0 counts every byte
+		// and 8 counts 256-byte pages
+		//******************************
+		explicit Heatmap(unsigned shift = 8);
+
+		//******************************
+		// Count one access of each kind
+		//******************************
+		inline void fetch(uint16_t address) noexcept { ++fetches[address >> shift]; }
+		inline void read(uint16_t address) noexcept { ++reads[address >> shift]; }
+		inline void write(uint16_t address) noexcept { ++writes[address >> shift]; }
+
+		//******************************
+		// Get the counters, one entry
+		// per 1 << shift bytes
+		//******************************
+		inline const std::vector<uint64_t>& get_fetches() const noexcept { return fetches; }
+		inline const std::vector<uint64_t>& get_reads() const noexcept { return reads; }
+		inline const std::vector<uint64_t>& get_writes() const noexcept { return writes; }
+		inline unsigned get_shift() const noexcept { return shift; }
+
+		//******************************
+		// Zero every counter
+		//******************************
+		void reset() noexcept;
+
+		//******************************
+		// Write one "address fetches
+		// reads writes" line for every
+		// range that was touched
+		//******************************
+		void write_table(std::ostream& out) const;
+	private:
+		unsigned shift;
+		std::vector<uint64_t> fetches;
+		std::vector<uint64_t> reads;
+		std::vector<uint64_t> writes;
+	};
+}
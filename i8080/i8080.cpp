@@ -9,16 +9,11 @@
 //**************************************
 #include "i8080.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <chrono>
 #include "opcodes.h"
-
-#define DEBUG_MESSAGES
-
-#ifdef DEBUG_MESSAGES
-#define MSG std::cout << "0x" << std::setfill('0') << std::setw(4) << std::hex << PC << "\n"
-#else
-#define MSG void()
-#endif
+#include "state_hash.h"
 
 //**************************************
 // Get the RP from an instruction
@@ -66,6 +61,31 @@ inline uint8_t parity(uint8_t in)
 	return even_parity;
 }
 
+//**************************************
+// Longest backward jump (in bytes) that
+// is checked for being an idle loop
+//**************************************
+const uint8_t idle_window = 16;
+
+//**************************************
+// Get whether an opcode leaves memory,
+// the stack and I/O alone, so it can
+// be part of an idle loop
+//**************************************
+inline bool idle_safe(const uint8_t& in)
+{
+	// STAX, SHLD and STA
+	if (in == 0x02 || in == 0x12 || in == 0x22 || in == 0x32) return false;
+	// INR M, DCR M and MVI M
+	if (in >= 0x34 && in <= 0x36) return false;
+	// MOV M,r and HLT
+	if (in >= 0x70 && in <= 0x77) return false;
+	if (in < 0xC0) return true;
+	// the only safe ones left are Jcc, the immediate arithmetic, JMP and XCHG
+	if ((in & 0x07) == 0x02 || (in & 0x07) == 0x06) return true;
+	return in == 0xC3 || in == 0xEB;
+}
+
 namespace i8080
 {
 	namespace flags
@@ -81,34 +101,313 @@ namespace i8080
 	}
 
 	//**********************************
-	// Run one cycle
+	// Every copy of the loops
 	//**********************************
+	const i8080::loop_table i8080::batches = i8080::batch_table(std::make_index_sequence<i8080::hook_all + 1>());
+	const i8080::loop_table i8080::steps = i8080::step_table(std::make_index_sequence<i8080::hook_all + 1>());
+
+	//**********************************
+	// Run until the deadline
+	//**********************************
+	bool i8080::run_until(uint64_t until)
+	{
+		// timed once per call rather than per batch so the clock
+		// reads stay out of the hot loop
+		auto start = std::chrono::steady_clock::now();
+		if (perf_events) perf_events->start();
+		if (hooks & hook_debug) debugger->resume();
+
+		bool alive = true;
+		while (cycles < until)
+		{
+			// run in batches up to the next event; right after EI
+			// events wait for one more instruction, so the batch is
+			// just that instruction
+			deadline = instructions == ei_shadow ? cycles + 1 : std::min(scheduler.next(), until);
+			// each mix of hooks gets its own copy of the loop, so
+			// the plain one doesn't pay for checking any of them
+			if (!(this->*batches[hooks])())
+			{
+				alive = false;
+				break;
+			}
+			if (instructions != ei_shadow) scheduler.dispatch(cycles);
+			// a breakpoint or watchpoint ends the run early
+			if ((hooks & hook_debug) && debugger->get_stop() != Debugger::Stop::None) break;
+		}
+
+		if (perf_events) perf_events->stop();
+		host_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		return alive;
+	}
+
+	//**********************************
+	// Run a single instruction
+	//**********************************
+	bool i8080::single_step()
+	{
+		if (hooks & hook_debug) debugger->resume();
+		if (instructions != ei_shadow) scheduler.dispatch(cycles);
+		deadline = scheduler.next();
+		return (this->*steps[hooks])();
+	}
+
+	//**********************************
+	// Run up to the deadline
+	//**********************************
+	template<uint8_t Hooks>
+	bool i8080::run_batch() noexcept
+	{
+		while (cycles < deadline)
+			if (!step<Hooks>()) return false;
+		return true;
+	}
+
+	//**********************************
+	// Run one instruction
+	//**********************************
+	template<uint8_t Hooks>
 	bool i8080::step() noexcept
 	{
-		static uint8_t wait = 0;
-		static uint8_t op = 0;
+		// a halted CPU has nothing to do until something wakes it
+		if (halted) return idle();
 
-		// implement cycle counting
-		if (wait > 0)
+		// stop before a breakpoint runs, unless it's the one we
+		// stopped at last time and are now continuing from
+		if (Hooks & hook_debug)
 		{
-			--wait;
-			return true;
+			if (!resuming && debugger->is_breakpoint(PC))
+			{
+				debugger->stop(Debugger::Stop::Breakpoint, PC, PC);
+				resuming = true;
+				deadline = cycles;
+				return true;
+			}
+			resuming = false;
 		}
+
+		if ((Hooks & hook_trace) && PC >= trace_first && PC <= trace_last) trace_sink->trace(*this);
+		uint16_t pc = PC;
+		uint16_t sp = SP;
+		uint16_t hl = (H << 8) | L;
+		uint8_t op = read8();
+		I8080_PROBE2(instruction, pc, op);
+		uint8_t result = (*this.*operations[op])(op);
+		uint8_t duration;
+		// result of 0 means success, and take the dur duration
+		if (result == 0)
+			duration = opcodes[op].dur;
+		// result of 1 means success, and take the alt duration
+		else if (result == 1)
+			duration = opcodes[op].alt;
 		else
+			return false;
+		cycles += duration;
+
+		if (Hooks & hook_count)
+		{
+			++opcode_counts[op];
+			opcode_cycles[op] += duration;
+		}
+
+		if (Hooks & hook_heatmap) count_accesses(pc, sp, hl, op, result == 0);
+
+		// watchpoints are found from what the instruction touched, so
+		// the memory accesses themselves never check for them
+		if ((Hooks & hook_debug) && debugger->has_watchpoints()) check_watchpoints(pc, sp, hl, op, result == 0);
+
+		// only calls and returns that were taken move the profiler; it
+		// goes by the opcode rather than where PC landed, so CALL $+3
+		// still counts as a call
+		if (Hooks & hook_profile)
+		{
+			profiler->charge(cycles);
+			bool taken = result == 0;
+			if (op == 0xCD || (op & 0xC7) == 0xC7 || ((op & 0xC7) == 0xC4 && taken)) profiler->call(PC, SP);
+			else if (op == 0xC9 || ((op & 0xC7) == 0xC0 && taken)) profiler->ret(sp);
+		}
+
+		if (++instructions == hash_at)
+		{
+			update_state_hash();
+			hash_at += hash_interval;
+			if (hash_report) hash_report(instructions, state_hash);
+		}
+
+		// a short backward JMP or Jcc (including JMP $ onto itself)
+		// might be closing an idle loop
+		if (PC <= pc && pc - PC <= idle_window && (op == 0xC3 || (op & 0xC7) == 0xC2))
+			return idle_loop(pc);
+		return true;
+	}
+
+	//**********************************
+	// Turn state hashing on or off
+	//**********************************
+	void i8080::enable_state_hash(uint64_t interval, std::function<void(uint64_t, uint64_t)> report)
+	{
+		hash_interval = interval;
+		hash_at = interval ? instructions + interval : UINT64_MAX;
+		hash_report = std::move(report);
+		if (interval) update_state_hash();
+	}
+
+	//**********************************
+	// Update the state hash
+	//**********************************
+	void i8080::update_state_hash() noexcept
+	{
+		// each page's hash is folded in with XOR, so swapping out
+		// the old hash of a written page for its new one is enough
+		uint32_t pages = (memory_size + 0xFF) >> 8;
+		for (uint32_t page = 0; page < pages; ++page)
+		{
+			uint32_t writes = page_writes[page].load(std::memory_order_relaxed);
+			if (writes == hashed_writes[page]) continue;
+			hashed_writes[page] = writes;
+			uint32_t start = page << 8;
+			uint64_t hash = hash_bytes(memory + start, std::min<uint32_t>(0x100, memory_size - start), page);
+			memory_hash ^= page_hashes[page] ^ hash;
+			page_hashes[page] = hash;
+		}
+
+		uint8_t regs[14] = { A, B, C, D, E, F, H, L,
+			static_cast<uint8_t>(PC & 0xFF), static_cast<uint8_t>(PC >> 8),
+			static_cast<uint8_t>(SP & 0xFF), static_cast<uint8_t>(SP >> 8),
+			inte, halted };
+		state_hash = hash_bytes(regs, sizeof(regs), hash_bytes(&cycles, sizeof(cycles), memory_hash));
+	}
+
+	//**********************************
+	// Visit an instruction's accesses
+	//**********************************
+	template<typename Visit>
+	void i8080::visit_accesses(const uint16_t pc, const uint16_t sp, const uint16_t hl, const uint8_t op, const bool taken, Visit&& visit) noexcept
+	{
+		for (uint8_t i = 0; i < opcodes[op].len; ++i)
+			visit(static_cast<uint16_t>(pc + i), access_fetch);
+
+		// MOV r,M and the arithmetic ops on M read at HL
+		if (((op & 0xC7) == 0x46 && op != 0x76) || (op & 0xC7) == 0x86)
+			visit(hl, access_read);
+		// MOV M,r and MVI M write at HL
+		else if (((op & 0xF8) == 0x70 && op != 0x76) || op == 0x36)
+			visit(hl, access_write);
+		// INR M and DCR M do both
+		else if (op == 0x34 || op == 0x35)
+		{
+			visit(hl, access_read);
+			visit(hl, access_write);
+		}
+		// LDAX and STAX go through BC or DE
+		else if (op == 0x0A || op == 0x1A)
+			visit(static_cast<uint16_t>(op == 0x0A ? (B << 8) | C : (D << 8) | E), access_read);
+		else if (op == 0x02 || op == 0x12)
+			visit(static_cast<uint16_t>(op == 0x02 ? (B << 8) | C : (D << 8) | E), access_write);
+		// LDA, STA, LHLD and SHLD use the address after the opcode
+		else if (op == 0x3A || op == 0x32 || op == 0x2A || op == 0x22)
+		{
+			uint16_t address = memory[static_cast<uint16_t>(pc + 1)] | (memory[static_cast<uint16_t>(pc + 2)] << 8);
+			uint8_t count = op & 0x10 ? 1 : 2;
+			for (uint8_t i = 0; i < count; ++i)
+				visit(static_cast<uint16_t>(address + i), op & 0x08 ? access_read : access_write);
+		}
+		// PUSH, CALL, RST and taken conditional calls store a word below SP
+		else if ((op & 0xCF) == 0xC5 || op == 0xCD || (op & 0xC7) == 0xC7 || ((op & 0xC7) == 0xC4 && taken))
+		{
+			visit(static_cast<uint16_t>(sp - 1), access_write);
+			visit(sp, access_write);
+		}
+		// POP, RET and taken conditional returns load the word at SP
+		else if ((op & 0xCF) == 0xC1 || op == 0xC9 || ((op & 0xC7) == 0xC0 && taken))
+		{
+			visit(static_cast<uint16_t>(sp + 1), access_read);
+			visit(static_cast<uint16_t>(sp + 2), access_read);
+		}
+	}
+
+	//**********************************
+	// Count an instruction's accesses
+	//**********************************
+	void i8080::count_accesses(const uint16_t pc, const uint16_t sp, const uint16_t hl, const uint8_t op, const bool taken) noexcept
+	{
+		visit_accesses(pc, sp, hl, op, taken, [this](uint16_t address, uint8_t kind)
+		{
+			if (kind == access_fetch) heatmap->fetch(address);
+			else if (kind == access_read) heatmap->read(address);
+			else heatmap->write(address);
+		});
+	}
+
+	//**********************************
+	// Check an instruction's accesses
+	// against the watchpoints
+	//**********************************
+	void i8080::check_watchpoints(const uint16_t pc, const uint16_t sp, const uint16_t hl, const uint8_t op, const bool taken) noexcept
+	{
+		visit_accesses(pc, sp, hl, op, taken, [this, pc](uint16_t address, uint8_t kind)
 		{
-			MSG;
-			op = read8();
-			uint8_t result = (*this.*operations[op])(op);
-			// result of 0 means success, and take the dur duration
-			if (result == 0)
-				wait = opcodes[op].dur;
-			// result of 1 means success, and take the alt duration
-			else if (result == 1)
-				wait = opcodes[op].alt;
-			else
-				return false;
+			if (kind == access_read && debugger->is_watched(address, Debugger::watch_read))
+				debugger->stop(Debugger::Stop::Read, pc, address);
+			else if (kind == access_write && debugger->is_watched(address, Debugger::watch_write))
+				debugger->stop(Debugger::Stop::Write, pc, address);
+			else return;
+			// finish this instruction, then leave the run loop
+			deadline = cycles;
+		});
+	}
+
+	//**********************************
+	// Skip ahead to the deadline
+	//**********************************
+	bool i8080::idle() noexcept
+	{
+		// only an interrupt wakes a halted CPU, so with them disabled
+		// or nothing scheduled to raise one it's stuck for good
+		if (!inte || deadline == UINT64_MAX) return false;
+		if (cycles < deadline) cycles = deadline;
+		return true;
+	}
+
+	//**********************************
+	// Check for and skip idle loops
+	//**********************************
+	bool i8080::idle_loop(const uint16_t branch) noexcept
+	{
+		std::array<uint8_t, 8> regs{ A, B, C, D, E, F, H, L };
+
+		// the loop has to be straight-line code that touches nothing
+		// but registers, so its length in cycles is fixed
+		uint64_t period = opcodes[memory[branch]].dur;
+		uint16_t addr = PC;
+		for (; addr < branch && period != 0; addr += opcodes[memory[addr]].len)
+		{
+			uint8_t op = memory[addr];
+			if (!idle_safe(op) || op == 0xC3 || (op & 0xC7) == 0xC2) period = 0;
+			else period += opcodes[op].dur;
+		}
+		if (addr != branch) period = 0;
+
+		// it's only idle if exactly one iteration went by since the last
+		// time we were here and it left every register as it found it
+		bool same = period != 0 && PC == idle_pc && SP == idle_sp
+			&& cycles - idle_cycle == period && regs == idle_regs;
+
+		idle_pc = PC;
+		idle_sp = SP;
+		idle_regs = regs;
+		if (!same)
+		{
+			idle_cycle = cycles;
 			return true;
 		}
+
+		// every iteration from here on is identical, so skip as many
+		// whole iterations as fit before the deadline
+		if (deadline == UINT64_MAX) return false;
+		if (deadline > cycles) cycles += (deadline - cycles) / period * period;
+		idle_cycle = cycles;
+		return true;
 	}
 
 	//******************************
@@ -185,6 +484,16 @@ namespace i8080
 		abort();
 	}
 
+	//******************************
+	// Set a register by number
+	//******************************
+	void i8080::set_reg(const uint8_t& arg, const uint8_t val) noexcept
+	{
+		// memory goes through write8 so the page gets marked
+		if (arg == 6) write8(read_rp(2), val);
+		else get_reg(arg) = val;
+	}
+
 	//**********************************
 	// JMP instruction
 	//**********************************
@@ -213,12 +522,10 @@ namespace i8080
 	//******************************
 	uint8_t i8080::mvi(const uint8_t& arg) noexcept
 	{
-		// get a reference to the register we want
-		uint8_t& reg = get_reg(dest(arg));
 		// get the immediate value we are writing
 		uint8_t val = read8();
-		// assign the value we read in to that register
-		reg = val;
+		// assign the value we read in to the register we want
+		set_reg(dest(arg), val);
 		return 0;
 	}
 
@@ -235,8 +542,8 @@ namespace i8080
 		// store our return address on the stack
 		assert(SP > 1);
 		SP -= 2;
-		memory[SP + 2] = (ret >> 8) & 0xFF;
-		memory[SP + 1] = (ret & 0xFF);
+		write8(SP + 2, (ret >> 8) & 0xFF);
+		write8(SP + 1, (ret & 0xFF));
 		return 0;
 	}
 
@@ -258,8 +565,7 @@ namespace i8080
 	uint8_t i8080::mov(const uint8_t& arg) noexcept
 	{
 		uint8_t val = get_reg(source(arg));
-		uint8_t& reg = get_reg(dest(arg));
-		reg = val;
+		set_reg(dest(arg), val);
 		return 0;
 	}
 
@@ -283,8 +589,8 @@ namespace i8080
 		// reset all flags but carry
 		F &= C;
 
-		// get our value (by reference!)
-		uint8_t& val = get_reg(dest(arg));
+		// get our value
+		uint8_t val = get_reg(dest(arg));
 		// if subtracting will make it negative, then set the sign bit
 		if (val == 0)
 		{
@@ -299,6 +605,7 @@ namespace i8080
 		// didn't implement aux. carry
 		else if (parity(val)) F |= flags::P;
 
+		set_reg(dest(arg), val);
 		return 0;
 	}
 
@@ -366,8 +673,8 @@ namespace i8080
 		uint16_t val = read_rp(rp(arg));
 		assert(SP > 1);
 		SP -= 2;
-		memory[SP + 2] = (val >> 8) & 0xFF;
-		memory[SP + 1] = (val & 0xFF);
+		write8(SP + 2, (val >> 8) & 0xFF);
+		write8(SP + 1, (val & 0xFF));
 		return 0;
 	}
 
@@ -420,6 +727,7 @@ namespace i8080
 		// so ignore the command
 		// but we do need to read the port address in
 		uint8_t addr = read8();
+		I8080_PROBE2(port_out, addr, A);
 		return 0;
 	}
 
@@ -653,8 +961,8 @@ namespace i8080
 			// store our return address on the stack
 			assert(SP > 1);
 			SP -= 2;
-			memory[SP + 2] = (ret >> 8) & 0xFF;
-			memory[SP + 1] = (ret & 0xFF);
+			write8(SP + 2, (ret >> 8) & 0xFF);
+			write8(SP + 1, (ret & 0xFF));
 			return 0;
 		}
 
@@ -666,8 +974,8 @@ namespace i8080
 	//**********************************
 	uint8_t i8080::inr(const uint8_t& arg) noexcept
 	{
-		uint8_t& reg = get_reg(dest(arg));
-		++reg;
+		uint8_t reg = get_reg(dest(arg));
+		set_reg(dest(arg), reg + 1);
 
 		return 0;
 	}
@@ -840,7 +1148,7 @@ namespace i8080
 	uint8_t i8080::sta(const uint8_t& arg) noexcept
 	{
 		uint16_t address = read16();
-		memory[address] = A;
+		write8(address, A);
 
 		return 0;
 	}
@@ -862,8 +1170,8 @@ namespace i8080
 	uint8_t i8080::shld(const uint8_t& arg) noexcept
 	{
 		uint16_t address = read16();
-		memory[address] = L;
-		memory[address + 1] = H;
+		write8(address, L);
+		write8(address + 1, H);
 		return 0;
 	}
 
@@ -874,7 +1182,7 @@ namespace i8080
 	{
 		uint8_t reg = rp(arg);
 		uint16_t address = read_rp(reg);
-		memory[address] = A;
+		write8(address, A);
 		return 0;
 	}
 
@@ -937,35 +1245,123 @@ namespace i8080
 		return 0;
 	}
 
+	//**********************************
+	// Restart (call a fixed vector)
+	//**********************************
+	uint8_t i8080::rst(const uint8_t& arg) noexcept
+	{
+		// save our return address
+		uint16_t ret = PC;
+		PC = dest(arg) << 3;
+		// store our return address on the stack
+		assert(SP > 1);
+		SP -= 2;
+		write8(SP + 2, (ret >> 8) & 0xFF);
+		write8(SP + 1, (ret & 0xFF));
+		return 0;
+	}
+
+	//**********************************
+	// Request an interrupt
+	//**********************************
+	bool i8080::interrupt(const uint8_t vector) noexcept
+	{
+		// EI only takes effect after the instruction following it, so
+		// an ISR's EI; RET returns before the next interrupt comes in
+		if (!inte || instructions == ei_shadow) return false;
+
+		// accepting an interrupt disables further ones and
+		// wakes us from HLT, then runs RST as if fetched
+		inte = false;
+		halted = false;
+		++interrupts;
+		I8080_PROBE2(interrupt, vector, PC);
+		uint8_t op = 0xC7 | ((vector & 7) << 3);
+		rst(op);
+		// PC moved, so a breakpoint we were continuing from is behind us
+		resuming = false;
+		if (hooks & hook_heatmap)
+		{
+			heatmap->write(SP + 1);
+			heatmap->write(SP + 2);
+		}
+		if ((hooks & hook_debug) && debugger->has_watchpoints())
+		{
+			for (uint16_t address : { static_cast<uint16_t>(SP + 1), static_cast<uint16_t>(SP + 2) })
+				if (debugger->is_watched(address, Debugger::watch_write))
+				{
+					debugger->stop(Debugger::Stop::Write, PC, address);
+					deadline = cycles;
+				}
+		}
+
+		// the time up to now (including any HLT) belongs to whatever
+		// was interrupted, and the handler is charged like a call
+		if (hooks & hook_profile)
+		{
+			profiler->charge(cycles);
+			profiler->call(PC, SP);
+		}
+		cycles += opcodes[op].dur;
+		return true;
+	}
+
 	//**********************************
 	// Load the program
 	//**********************************
 	void i8080::load_program(uint16_t offset) noexcept
 	{
-		// start loading
-		while (!file.eof()) memory[offset++] = file.get();
+		// start loading, stopping before the EOF marker
+		uint32_t address = offset;
+		int byte;
+		while (address < memory_size && (byte = file.get()) != std::char_traits<char>::eof())
+			write8(static_cast<uint16_t>(address++), static_cast<uint8_t>(byte));
 		// set the stack to where the program finished
-		SP = offset;
+		SP = static_cast<uint16_t>(address);
+	}
+
+	//**********************************
+	// Copy bytes into memory
+	//**********************************
+	void i8080::load(uint16_t address, const uint8_t* data, size_t size) noexcept
+	{
+		// nothing lands past the end, and subtracting would wrap
+		if (address >= memory_size) return;
+		size_t count = std::min<size_t>(size, memory_size - address);
+		std::copy_n(data, count, memory + address);
+		// every page touched counts as written, like write8 does
+		for (uint32_t page = address >> 8; count && page <= (address + count - 1) >> 8; ++page)
+			page_writes[page].store(page_writes[page].load(std::memory_order_relaxed) + 1, std::memory_order_release);
 	}
 
 	//**********************************
 	// Constructor
 	//**********************************
-	i8080::i8080(const char* filename, uint16_t size, uint16_t offset) 
-		: memory(nullptr), file(filename, std::ios_base::binary), operations()
+	i8080::i8080(const char* filename, uint16_t size, uint16_t offset)
+		: i8080(size)
 	{
+		file.open(filename, std::ios_base::binary);
 		if (!file.is_open()) throw -1;
 
-		using namespace i8080;
-
-		// first allocate the amount of memory that we want
-		memory = new uint8_t[static_cast<int>(size) + 1];
-
 		// read in the file to memory
 		load_program(offset);
 
 		// set our offset
 		PC = offset;
+	}
+
+	//**********************************
+	// Constructor
+	//**********************************
+	i8080::i8080(uint16_t size)
+		: memory(nullptr), memory_size(static_cast<uint32_t>(size) + 1), operations()
+	{
+		using namespace i8080;
+
+		// first allocate the amount of memory that we want
+		memory = new uint8_t[memory_size]();
+		// nothing has been hashed yet, so every page needs it
+		hashed_writes.fill(UINT32_MAX);
 
 		// start initializing the array of operations
 		// by filling it with operations which crash
@@ -1174,12 +1570,14 @@ namespace i8080
 		operations[0xC4] = &i8080::cc;
 		operations[0xC5] = &i8080::push;
 		operations[0xC6] = &i8080::adi;
+		operations[0xC7] = &i8080::rst;
 		operations[0xC8] = &i8080::rc;
 		operations[0xC9] = &i8080::ret;
 		operations[0xCA] = &i8080::jc;
 		operations[0xCC] = &i8080::cc;
 		operations[0xCD] = &i8080::call;
 		operations[0xCE] = &i8080::aci;
+		operations[0xCF] = &i8080::rst;
 
 		operations[0xD0] = &i8080::rc;
 		operations[0xD1] = &i8080::pop;
@@ -1188,10 +1586,13 @@ namespace i8080
 		operations[0xD4] = &i8080::cc;
 		operations[0xD5] = &i8080::push;
 		operations[0xD6] = &i8080::sui;
+		operations[0xD7] = &i8080::rst;
 		operations[0xD8] = &i8080::rc;
 		operations[0xDA] = &i8080::jc;
+		operations[0xDB] = &i8080::in;
 		operations[0xDC] = &i8080::cc;
 		operations[0xDE] = &i8080::sbi;
+		operations[0xDF] = &i8080::rst;
 
 		operations[0xE0] = &i8080::rc;
 		operations[0xE1] = &i8080::pop;
@@ -1199,21 +1600,27 @@ namespace i8080
 		operations[0xE4] = &i8080::cc;
 		operations[0xE5] = &i8080::push;
 		operations[0xE6] = &i8080::ani;
+		operations[0xE7] = &i8080::rst;
 		operations[0xE8] = &i8080::rc;
 		operations[0xEA] = &i8080::jc;
 		operations[0xEB] = &i8080::exchg;
 		operations[0xEC] = &i8080::cc;
 		operations[0xEE] = &i8080::xri;
+		operations[0xEF] = &i8080::rst;
 
 		operations[0xF0] = &i8080::rc;
 		operations[0xF1] = &i8080::pop;
 		operations[0xF2] = &i8080::jc;
+		operations[0xF3] = &i8080::di;
 		operations[0xF4] = &i8080::cc;
 		operations[0xF5] = &i8080::push;
 		operations[0xF6] = &i8080::ori;
+		operations[0xF7] = &i8080::rst;
 		operations[0xF8] = &i8080::rc;
 		operations[0xFA] = &i8080::jc;
+		operations[0xFB] = &i8080::ei;
 		operations[0xFC] = &i8080::cc;
 		operations[0xFE] = &i8080::cpi;
+		operations[0xFF] = &i8080::rst;
 	}
 }
\ No newline at end of file
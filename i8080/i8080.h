@@ -11,22 +11,55 @@
 
 #include <fstream>
 #include <array>
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <utility>
 
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#include "debugger.h"
+#include "heatmap.h"
+#include "perf_events.h"
+#include "probes.h"
+#include "profiler.h"
+#include "relaxed.h"
+#include "scheduler.h"
+#include "trace.h"
+
 namespace i8080
 {
+	// a copy of the registers and CPU flags
+	struct State
+	{
+		uint8_t A, B, C, D, E, F, H, L;
+		uint16_t PC, SP;
+		uint64_t cycles;
+		bool inte, halted;
+	};
+
 	class i8080 final
 	{
 	public:
 		//******************************
-		// Constructor
+		// Constructor, loads a raw
+		// image at offset and starts
+		// running from there
+		//
+		// Throws -1 when the file could
+		// not be opened
 		//******************************
 		i8080(const char* filename, uint16_t size = 0xFFFF, uint16_t offset = 0x0);
 
+		//******************************
+		// Constructor, starts with
+		// empty memory for a loader to
+		// fill
+		//******************************
+		explicit i8080(uint16_t size = 0xFFFF);
+
 		//******************************
 		// Destructor
 		//******************************
@@ -35,11 +68,255 @@ namespace i8080
 		//******************************
 		// Run the emulation
 		//******************************
-		void run() noexcept
+		void run()
+		{
+			// simply run forever until the CPU halts 
+			run_until(UINT64_MAX);
+		}
+
+		//******************************
+		// Run the emulation until the
+		// cycle counter reaches until,
+		// dispatching events as they
+		// come due
+		//
+		// Returns false when the CPU
+		// stopped and can never resume
+		//******************************
+		bool run_until(uint64_t until);
+
+		//******************************
+		// Run a single instruction,
+		// dispatching any events that
+		// are due first
+		//
+		// Returns false when the CPU
+		// stopped and can never resume
+		//******************************
+		bool single_step();
+
+		//******************************
+		// Get the number of cycles run
+		//******************************
+		inline uint64_t get_cycles() const noexcept { return cycles; }
+
+		//******************************
+		// Get the number of instructions
+		// run (skipped idle loops don't
+		// count)
+		//******************************
+		inline uint64_t get_instructions() const noexcept { return instructions; }
+
+		//******************************
+		// Get how many times a 256 byte
+		// page of memory has been written
+		//
+		// Safe to call from any thread;
+		// a count that hasn't changed
+		// means the page hasn't either
+		//******************************
+		inline uint32_t get_page_writes(uint8_t page) const noexcept { return page_writes[page].load(std::memory_order_acquire); }
+
+		//******************************
+		// Copy bytes into memory at an
+		// address, as a loader would,
+		// dropping any past the end
+		//******************************
+		void load(uint16_t address, const uint8_t* data, size_t size) noexcept;
+
+		//******************************
+		// Set where execution continues
+		//******************************
+		inline void set_pc(uint16_t address) noexcept { PC = address; halted = false; resuming = false; }
+
+		//******************************
+		// Set the stack pointer
+		//******************************
+		inline void set_sp(uint16_t address) noexcept { SP = address; }
+
+		//******************************
+		// Get the number of interrupts
+		// accepted
+		//******************************
+		inline uint64_t get_interrupts() const noexcept { return interrupts; }
+
+		//******************************
+		// Get the host time spent inside
+		// run_until, in nanoseconds
+		//******************************
+		inline uint64_t get_host_time() const noexcept { return host_time; }
+
+		//******************************
+		// Count host hardware events
+		// while run_until runs, or stop
+		// with null events
+		//******************************
+		inline void set_perf_events(PerfEvents* events) noexcept { perf_events = events; }
+
+		//******************************
+		// Get the scheduler devices use
+		// to register timed events
+		//******************************
+		inline Scheduler& get_scheduler() noexcept { return scheduler; }
+
+		//******************************
+		// Request an interrupt which
+		// runs RST vector
+		//
+		// Returns false when interrupts
+		// are disabled (or EI hasn't
+		// taken effect yet) and it was
+		// ignored; scheduled events are
+		// held until EI has
+		//******************************
+		bool interrupt(const uint8_t vector) noexcept;
+
+		//******************************
+		// Set the value the CPU reads
+		// from an input port with IN
+		//******************************
+		inline void set_input(const uint8_t port, const uint8_t value) noexcept { inputs[port] = value; }
+
+		//******************************
+		// Get read-only access to memory
+		//******************************
+		inline const uint8_t* get_memory() const noexcept { return memory; }
+
+		//******************************
+		// Get the size of memory
+		//******************************
+		inline uint32_t get_memory_size() const noexcept { return memory_size; }
+
+		//******************************
+		// Get a copy of the registers
+		//******************************
+		inline State get_state() const noexcept { return State{ A, B, C, D, E, F, H, L, PC, SP, cycles, inte, halted }; }
+
+		//******************************
+		// Report every instruction with
+		// a PC from first to last to
+		// sink, or turn tracing off
+		// with a null sink
+		//
+		// Untraced runs use a separate
+		// loop that never checks for it
+		//******************************
+		inline void set_trace(TraceSink* sink, uint16_t first = 0x0000, uint16_t last = 0xFFFF) noexcept
+		{
+			trace_sink = sink;
+			trace_first = first;
+			trace_last = last;
+			if (sink) hooks |= hook_trace;
+			else hooks &= ~hook_trace;
+		}
+
+		//******************************
+		// Turn counting how many times
+		// each opcode runs, and how many
+		// cycles it takes, on or off
+		//
+		// Runs without it use a loop
+		// that never counts
+		//******************************
+		inline void enable_opcode_counts(bool enable) noexcept
+		{
+			if (enable) hooks |= hook_count;
+			else hooks &= ~hook_count;
+		}
+
+		//******************************
+		// Charge cycles to guest routines
+		// in profiler by following calls
+		// and returns, or stop with a
+		// null profiler
+		//
+		// Runs without it use a loop
+		// that never checks for it
+		//******************************
+		inline void set_profiler(Profiler* profiler) noexcept
+		{
+			this->profiler = profiler;
+			if (profiler)
+			{
+				profiler->sync(cycles);
+				hooks |= hook_profile;
+			}
+			else hooks &= ~hook_profile;
+		}
+
+		//******************************
+		// Count the memory touched by
+		// each instruction in heatmap,
+		// or stop with a null heatmap
+		//
+		// Runs without it use a loop
+		// that never checks for it
+		//******************************
+		inline void set_heatmap(Heatmap* heatmap) noexcept
+		{
+			this->heatmap = heatmap;
+			if (heatmap) hooks |= hook_heatmap;
+			else hooks &= ~hook_heatmap;
+		}
+
+		//******************************
+		// Stop at the breakpoints and
+		// watchpoints in debugger, or
+		// stop checking with a null
+		// debugger
+		//
+		// Runs without it use a loop
+		// that never checks for them,
+		// so they cost nothing until
+		// one is wanted
+		//******************************
+		inline void set_debugger(Debugger* debugger) noexcept
 		{
-			// simply step forever until the CPU halts 
-			while (step());
+			this->debugger = debugger;
+			resuming = false;
+			if (debugger) hooks |= hook_debug;
+			else hooks &= ~hook_debug;
 		}
+
+		//******************************
+		// Get how many times each opcode
+		// has run while counting was on
+		//******************************
+		inline const std::array<uint64_t, 256>& get_opcode_counts() const noexcept { return opcode_counts; }
+
+		//******************************
+		// Get the cycles spent on each
+		// opcode while counting was on
+		//******************************
+		inline const std::array<uint64_t, 256>& get_opcode_cycles() const noexcept { return opcode_cycles; }
+
+		//******************************
+		// Zero the opcode counters
+		//******************************
+		inline void reset_opcode_counts() noexcept
+		{
+			opcode_counts.fill(0);
+			opcode_cycles.fill(0);
+		}
+
+		//******************************
+		// Keep a hash of the registers,
+		// cycle count and memory, updated
+		// every interval instructions,
+		// and pass each new one along
+		// with the instruction count to
+		// report if given
+		//
+		// Only pages written since the
+		// last update get rehashed. An
+		// interval of 0 turns it off
+		//******************************
+		void enable_state_hash(uint64_t interval, std::function<void(uint64_t, uint64_t)> report = nullptr);
+
+		//******************************
+		// Get the most recent state hash
+		//******************************
+		inline uint64_t get_state_hash() const noexcept { return state_hash; }
 	private:
 		// define the registers
 		// accumulator
@@ -59,6 +336,14 @@ namespace i8080
 		uint8_t data_bus = 0;
 
 		uint8_t* memory;
+		uint32_t memory_size;
+
+		// how many writes each 256 byte page of memory has had;
+		// only the CPU's thread changes them, but others may read
+		// them to notice when a page changed
+		std::array<std::atomic<uint32_t>, 256> page_writes{};
+		// the counts when each page was last hashed
+		std::array<uint32_t, 256> hashed_writes;
 
 		std::ifstream file;
 
@@ -68,11 +353,159 @@ namespace i8080
 		// debug information for the current step we are on
 		uint16_t current_step = 0;
 
+		// total number of cycles and instructions run so far
+		uint64_t cycles = 0;
+		uint64_t instructions = 0;
+		// interrupts accepted so far
+		uint64_t interrupts = 0;
+		// host nanoseconds spent in run_until
+		uint64_t host_time = 0;
+		// host counters wrapped around run_until
+		PerfEvents* perf_events = nullptr;
+		// the cycle count the current run stops at
+		uint64_t deadline = UINT64_MAX;
+		// set by HLT until something wakes the CPU
+		bool halted = false;
+		// interrupt enable, set by EI and cleared by DI
+		bool inte = false;
+		// the instruction count right after the last EI, while
+		// which interrupts still wait for one more instruction
+		uint64_t ei_shadow = UINT64_MAX;
+
+		// events that devices have scheduled
+		Scheduler scheduler;
+
+		// latched values for the input ports
+		std::array<uint8_t, 256> inputs{};
+
+		// state hashing, with each page's last hash kept
+		// so only pages written since need to be hashed again
+		uint64_t hash_interval = 0;
+		uint64_t hash_at = UINT64_MAX;
+		uint64_t memory_hash = 0;
+		uint64_t state_hash = 0;
+		std::array<uint64_t, 256> page_hashes{};
+		std::function<void(uint64_t, uint64_t)> hash_report;
+
+		// the optional work done around each instruction, each
+		// mix of which has its own copy of the run loop
+		enum : uint8_t
+		{
+			hook_trace = 1 << 0,
+			hook_count = 1 << 1,
+			hook_profile = 1 << 2,
+			hook_heatmap = 1 << 3,
+			hook_debug = 1 << 4,
+			hook_all = (1 << 5) - 1
+		};
+		uint8_t hooks = 0;
+
+		// per opcode run counts and cycles
+		std::array<uint64_t, 256> opcode_counts{};
+		std::array<uint64_t, 256> opcode_cycles{};
+
+		// where guest routines get charged for their cycles
+		Profiler* profiler = nullptr;
+
+		// where memory accesses get counted
+		Heatmap* heatmap = nullptr;
+
+		// where breakpoints and watchpoints are kept, and
+		// whether the next instruction is the breakpoint we
+		// stopped at, which has to run for the CPU to continue
+		Debugger* debugger = nullptr;
+		bool resuming = false;
+
+		// where traced instructions get reported
+		TraceSink* trace_sink = nullptr;
+		uint16_t trace_first = 0x0000;
+		uint16_t trace_last = 0xFFFF;
+
+		// the loop head and state seen on the last
+		// backward jump, used to spot idle loops
+		uint16_t idle_pc = 0;
+		uint16_t idle_sp = 0;
+		uint64_t idle_cycle = 0;
+		std::array<uint8_t, 8> idle_regs{};
+
+		//******************************
+		// Run instructions up to the
+		// deadline
+		//******************************
+		template<uint8_t Hooks>
+		bool run_batch() noexcept;
+
 		//******************************
-		// Run one cycle
+		// Run one instruction
 		//******************************
+		template<uint8_t Hooks>
 		bool step() noexcept;
 
+		// every copy of run_batch and step, indexed by hooks
+		using loop_table = std::array<bool (i8080::*)() noexcept, hook_all + 1>;
+		static const loop_table batches;
+		static const loop_table steps;
+
+		//******************************
+		// Fill in the tables of loops
+		//******************************
+		template<size_t... I>
+		static constexpr loop_table batch_table(std::index_sequence<I...>) noexcept { return { &i8080::run_batch<static_cast<uint8_t>(I)>... }; }
+		template<size_t... I>
+		static constexpr loop_table step_table(std::index_sequence<I...>) noexcept { return { &i8080::step<static_cast<uint8_t>(I)>... }; }
+
+		//******************************
+		// Rehash dirty pages and update
+		// the state hash
+		//******************************
+		void update_state_hash() noexcept;
+
+		// the kinds of memory access an instruction makes
+		enum : uint8_t
+		{
+			access_fetch,
+			access_read,
+			access_write
+		};
+
+		//******************************
+		// Pass every memory access an
+		// executed instruction made to
+		// visit, given the SP and HL it
+		// started with
+		//******************************
+		template<typename Visit>
+		void visit_accesses(const uint16_t pc, const uint16_t sp, const uint16_t hl, const uint8_t op, const bool taken, Visit&& visit) noexcept;
+
+		//******************************
+		// Count the memory an executed
+		// instruction touched
+		//******************************
+		void count_accesses(const uint16_t pc, const uint16_t sp, const uint16_t hl, const uint8_t op, const bool taken) noexcept;
+
+		//******************************
+		// Stop if an executed
+		// instruction touched a
+		// watchpoint
+		//******************************
+		void check_watchpoints(const uint16_t pc, const uint16_t sp, const uint16_t hl, const uint8_t op, const bool taken) noexcept;
+
+		//******************************
+		// Skip ahead to the deadline
+		// while there is nothing to run,
+		// or return false when no
+		// interrupt can wake the CPU
+		//******************************
+		bool idle() noexcept;
+
+		//******************************
+		// Check whether the backward
+		// jump at branch closes a loop
+		// that can't change anything,
+		// and skip it ahead if so
+		//******************************
+		bool idle_loop(const uint16_t branch) noexcept;
+
 		//******************************
 		// Get a register pair
 		//******************************
@@ -88,6 +521,11 @@ namespace i8080
 		//******************************
 		uint8_t& get_reg(const uint8_t& arg) noexcept;
 
+		//******************************
+		// Set a register by number
+		//******************************
+		void set_reg(const uint8_t& arg, const uint8_t val) noexcept;
+
 		//******************************
 		// NOP instruction
 		//******************************
@@ -161,7 +599,12 @@ namespace i8080
 		//******************************
 		// HLT instruction
 		//******************************
-		inline uint8_t hlt(const uint8_t& arg) noexcept { return 2; }
+		inline uint8_t hlt(const uint8_t& arg) noexcept
+		{
+			halted = true;
+			I8080_PROBE2(halt, static_cast<uint16_t>(PC - 1), cycles);
+			return 0;
+		}
 
 		//******************************
 		// DAD instruction
@@ -178,6 +621,17 @@ namespace i8080
 		//******************************
 		uint8_t out(const uint8_t& arg) noexcept;
 
+		//******************************
+		// IN instruction
+		//******************************
+		inline uint8_t in(const uint8_t& arg) noexcept
+		{
+			uint8_t port = read8();
+			A = inputs[port];
+			I8080_PROBE2(port_in, port, A);
+			return 0;
+		}
+
 		//******************************
 		// RRC instruction
 		//******************************
@@ -323,6 +777,26 @@ namespace i8080
 		//******************************
 		uint8_t daa(const uint8_t& arg) noexcept;
 
+		//******************************
+		// Restart (call a fixed vector)
+		//******************************
+		uint8_t rst(const uint8_t& arg) noexcept;
+
+		//******************************
+		// Enable interrupts
+		//******************************
+		inline uint8_t ei(const uint8_t& arg) noexcept
+		{
+			inte = true;
+			ei_shadow = instructions + 1;
+			return 0;
+		}
+
+		//******************************
+		// Disable interrupts
+		//******************************
+		inline uint8_t di(const uint8_t& arg) noexcept { inte = false; return 0; }
+
 		//******************************
 		// Unimplemented instructions
 		//******************************
@@ -345,6 +819,20 @@ namespace i8080
 		//*******************************
 		inline uint8_t read8() noexcept { return memory[PC++]; }
 
+		//*******************************
+		// Write 1 byte to memory
+		//*******************************
+		inline void write8(const uint16_t address, const uint8_t val) noexcept
+		{
+			// relaxed so a thread reading memory alongside isn't racing
+			// a plain store (it compiles to the same single move)
+			store_relaxed(memory + address, val);
+			// with a single writer a plain load and store is enough,
+			// and release makes the byte visible before the count
+			std::atomic<uint32_t>& writes = page_writes[address >> 8];
+			writes.store(writes.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
 		//*******************************
 		// Load the program
 		//*******************************
@@ -0,0 +1,270 @@
+//**************************************
+// listing_writer.cpp
+//
+// Holds the definition of the listing
+// writer, which formats disassembled
+// instructions into large reusable
+// buffers and writes them out in big
+// blocks, optionally on its own thread
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "listing_writer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "mnemonics.h"
+
+namespace i8080
+{
+	static const char digits[] = "0123456789abcdef";
+
+	//**********************************
+	// Write value as count hex digits
+	// after 0x
+	//**********************************
+	static inline char* put_hex(char* out, unsigned value, int count) noexcept
+	{
+		*out++ = '0';
+		*out++ = 'x';
+		for (int shift = (count - 1) * 4; shift >= 0; shift -= 4)
+			*out++ = digits[(value >> shift) & 0xF];
+		return out;
+	}
+
+	//**********************************
+	// Write value in decimal
+	//**********************************
+	static inline char* put_decimal(char* out, unsigned value) noexcept
+	{
+		char reversed[5];
+		int count = 0;
+		do
+		{
+			reversed[count++] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while (value);
+		while (count) *out++ = reversed[--count];
+		return out;
+	}
+
+	//**********************************
+	// Write a string
+	//**********************************
+	static inline char* put(char* out, std::string_view text) noexcept
+	{
+		return std::copy(text.begin(), text.end(), out);
+	}
+
+	//**********************************
+	// Write a symbol name, cut at
+	// max_name, with quotes doubled
+	// for CSV or escaped for JSON
+	//**********************************
+	static inline char* put_name(char* out, std::string_view name, bool json) noexcept
+	{
+		name = name.substr(0, SymbolTable::max_name);
+		for (char c : name)
+		{
+			// JSON strings can't hold raw control characters
+			if (json && static_cast<unsigned char>(c) < 0x20)
+			{
+				out = put(out, "\\u00");
+				*out++ = digits[c >> 4];
+				*out++ = digits[c & 0xF];
+				continue;
+			}
+			if (c == '"') *out++ = json ? '\\' : '"';
+			else if (c == '\\' && json) *out++ = '\\';
+			*out++ = c;
+		}
+		return out;
+	}
+
+	//**********************************
+	// Constructors
+	//**********************************
+	ListingWriter::ListingWriter(const std::string& filename, ListingFormat format, bool background, size_t buffer_size)
+		: file(filename, std::ios_base::binary | std::ios_base::trunc), out(file), format(format), background(background)
+	{
+		if (!file.is_open()) throw -1;
+		start(buffer_size);
+	}
+
+	ListingWriter::ListingWriter(std::ostream& out, ListingFormat format, bool background, size_t buffer_size)
+		: out(out), format(format), background(background)
+	{
+		start(buffer_size);
+	}
+
+	//**********************************
+	// Set up the buffers and thread
+	//**********************************
+	void ListingWriter::start(size_t buffer_size)
+	{
+		buffer_size = std::max(buffer_size, max_line * 2);
+		for (std::vector<char>& buffer : buffers) buffer.resize(buffer_size);
+		for (uint8_t slot = 1; slot < buffer_count; ++slot) empty.try_push(slot);
+
+		if (format == ListingFormat::Csv)
+			used = put(buffers[0].data(), "address,opcode,length,mnemonic,operands,operand,label,symbol\n") - buffers[0].data();
+		if (background) writer = std::thread(&ListingWriter::write_loop, this);
+	}
+
+	//**********************************
+	// Add an instruction
+	//**********************************
+	void ListingWriter::write(const Instruction& instruction)
+	{
+		if (buffers[current].size() - used < max_line) rotate();
+
+		char* start = buffers[current].data() + used;
+		char* cursor = start;
+		const MnemonicInfo& mnemonic = mnemonics[instruction.opcode];
+
+		// the name at this address, and the one its address operand
+		// points to, the same ones text listings show
+		std::string_view label, symbol;
+		if (symbols)
+		{
+			label = symbols->find(instruction.address);
+			if (instruction.length == 3) symbol = symbols->find(instruction.operand);
+		}
+
+		switch (format)
+		{
+		case ListingFormat::Text:
+			if (!label.empty())
+			{
+				cursor = std::copy_n(label.begin(), std::min(label.size(), SymbolTable::max_name), cursor);
+				*cursor++ = ':';
+				*cursor++ = '\n';
+			}
+			cursor += Disassembler::FormatInstruction(instruction, cursor, symbols);
+			break;
+		case ListingFormat::Csv:
+			// the operands hold commas (MOV B,C), so they're quoted,
+			// as are names, which could hold anything
+			cursor = put_hex(cursor, instruction.address, 4);
+			*cursor++ = ',';
+			cursor = put_hex(cursor, instruction.opcode, 2);
+			*cursor++ = ',';
+			cursor = put_decimal(cursor, instruction.length);
+			*cursor++ = ',';
+			cursor = put(cursor, mnemonic.name);
+			cursor = put(cursor, ",\"");
+			cursor = put(cursor, mnemonic.operands);
+			cursor = put(cursor, "\",");
+			if (instruction.length > 1) cursor = put_hex(cursor, instruction.operand, instruction.length == 2 ? 2 : 4);
+			cursor = put(cursor, ",\"");
+			cursor = put_name(cursor, label, false);
+			cursor = put(cursor, "\",\"");
+			cursor = put_name(cursor, symbol, false);
+			*cursor++ = '"';
+			break;
+		case ListingFormat::JsonLines:
+			cursor = put(cursor, "{\"address\":");
+			cursor = put_decimal(cursor, instruction.address);
+			cursor = put(cursor, ",\"opcode\":");
+			cursor = put_decimal(cursor, instruction.opcode);
+			cursor = put(cursor, ",\"length\":");
+			cursor = put_decimal(cursor, instruction.length);
+			cursor = put(cursor, ",\"mnemonic\":\"");
+			cursor = put(cursor, mnemonic.name);
+			cursor = put(cursor, "\",\"operands\":\"");
+			cursor = put(cursor, mnemonic.operands);
+			*cursor++ = '"';
+			if (instruction.length > 1)
+			{
+				cursor = put(cursor, ",\"operand\":");
+				cursor = put_decimal(cursor, instruction.operand);
+			}
+			cursor = put(cursor, ",\"label\":\"");
+			cursor = put_name(cursor, label, true);
+			cursor = put(cursor, "\",\"symbol\":\"");
+			cursor = put_name(cursor, symbol, true);
+			cursor = put(cursor, "\"}");
+			break;
+		}
+		*cursor++ = '\n';
+		used += cursor - start;
+	}
+
+	//**********************************
+	// Add every instruction in an image
+	//**********************************
+	void ListingWriter::write(const uint8_t* image, size_t size, uint16_t base)
+	{
+		Instruction instruction;
+		size_t offset = 0;
+		while (Disassembler::DecodeInstruction(image + offset, size - offset, static_cast<uint16_t>(base + offset), instruction))
+		{
+			write(instruction);
+			offset += instruction.length;
+		}
+	}
+
+	//**********************************
+	// Hand the current buffer over
+	//**********************************
+	void ListingWriter::rotate()
+	{
+		if (!background)
+		{
+			out.write(buffers[current].data(), used);
+			used = 0;
+			return;
+		}
+
+		// the queue publishes the length along with the index
+		lengths[current] = used;
+		filled.try_push(current);
+		while (!empty.try_pop(current)) std::this_thread::yield();
+		used = 0;
+	}
+
+	//**********************************
+	// Write everything and stop
+	//**********************************
+	void ListingWriter::close() noexcept
+	{
+		if (closed) return;
+		closed = true;
+
+		if (used) rotate();
+		closing.store(true, std::memory_order_release);
+		if (writer.joinable()) writer.join();
+		out.flush();
+		if (file.is_open()) file.close();
+	}
+
+	//**********************************
+	// The background writer's loop
+	//**********************************
+	void ListingWriter::write_loop()
+	{
+		for (;;)
+		{
+			// check before draining, so anything handed over
+			// before we were closed is sure to be seen
+			bool done = closing.load(std::memory_order_acquire);
+
+			uint8_t slot;
+			bool wrote = false;
+			while (filled.try_pop(slot))
+			{
+				out.write(buffers[slot].data(), lengths[slot]);
+				empty.try_push(slot);
+				wrote = true;
+			}
+
+			if (!wrote)
+			{
+				if (done) break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+}
@@ -0,0 +1,141 @@
+//**************************************
+// listing_writer.h
+//
+// Holds the declaration of the listing
+// writer, which formats disassembled
+// instructions into large reusable
+// buffers and writes them out in big
+// blocks, optionally on its own thread
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "disassembler.h"
+#include "spsc_queue.h"
+
+namespace i8080
+{
+	enum class ListingFormat : uint8_t
+	{
+		// the same lines the disassembler prints
+		Text,
+		// address,opcode,length,mnemonic,operands,operand,label,symbol
+		Csv,
+		// one JSON object per line
+		JsonLines
+	};
+
+	class ListingWriter final
+	{
+	public:
+		//******************************
+		// Constructor, writes to a file
+		//
+		// With background set, buffers
+		// are written on a thread of
+		// their own while the next ones
+		// fill up
+		//
+		// Throws -1 when the file could
+		// not be created
+		//******************************
+		ListingWriter(const std::string& filename, ListingFormat format = ListingFormat::Text,
+			bool background = false, size_t buffer_size = 1 << 20);
+
+		//******************************
+		// Constructor, writes to a
+		// stream that outlives it
+		//******************************
+		ListingWriter(std::ostream& out, ListingFormat format = ListingFormat::Text,
+			bool background = false, size_t buffer_size = 1 << 20);
+
+		//******************************
+		// Destructor, writes whatever
+		// is left
+		//******************************
+		inline ~ListingWriter() noexcept { close(); }
+
+		//******************************
+		// Show addresses that have a
+		// symbol by name, and put label
+		// lines before them in text
+		// listings. CSV and JSON lines
+		// get them in their label and
+		// symbol fields, which are
+		// otherwise empty
+		//******************************
+		inline void set_symbols(const SymbolTable* symbols) noexcept { this->symbols = symbols; }
+
+		//******************************
+		// Add an instruction
+		//
+		// Only waits when every buffer
+		// is full and still waiting to
+		// be written
+		//******************************
+		void write(const Instruction& instruction);
+
+		//******************************
+		// Decode and add every whole
+		// instruction in an image
+		//******************************
+		void write(const uint8_t* image, size_t size, uint16_t base);
+
+		//******************************
+		// Write out everything added so
+		// far and stop the background
+		// thread
+		//******************************
+		void close() noexcept;
+	private:
+		// the longest line any format writes, with room for two
+		// names whose every character is escaped as \u00XX
+		static const size_t max_line = 128 + 12 * SymbolTable::max_name;
+		static const uint8_t buffer_count = 4;
+
+		std::ofstream file;
+		std::ostream& out;
+		ListingFormat format;
+		bool background;
+		const SymbolTable* symbols = nullptr;
+
+		std::vector<char> buffers[buffer_count];
+		size_t lengths[buffer_count] = {};
+		uint8_t current = 0;
+		size_t used = 0;
+		bool closed = false;
+
+		// the two threads pass buffer indices back and forth, like
+		// the trace writer does with keyframes
+		SpscQueue<uint8_t, 8> filled;
+		SpscQueue<uint8_t, 8> empty;
+		std::thread writer;
+		std::atomic<bool> closing{ false };
+
+		//******************************
+		// Set up the buffers and thread
+		//******************************
+		void start(size_t buffer_size);
+
+		//******************************
+		// Hand the current buffer over
+		// and pick up an empty one
+		//******************************
+		void rotate();
+
+		//******************************
+		// The background writer's loop
+		//******************************
+		void write_loop();
+	};
+}
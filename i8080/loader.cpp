@@ -0,0 +1,238 @@
+//**************************************
+// loader.cpp
+//
+// Holds the definition of the image
+// loaders, which stream raw binaries,
+// CP/M .COM files and Intel HEX files
+// straight into the CPU's memory, and
+// of the manifest that lays several of
+// them out at once
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "loader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+namespace i8080
+{
+	//**********************************
+	// Note a block that was written
+	//**********************************
+	static void record(LoadResult& result, uint32_t address, size_t count) noexcept
+	{
+		if (!count) return;
+		result.low = std::min(result.low, address);
+		result.high = std::max(result.high, address + static_cast<uint32_t>(count));
+		result.bytes += static_cast<uint32_t>(count);
+	}
+
+	//**********************************
+	// Parse a hex number
+	//**********************************
+	static bool parse_hex(const std::string& text, uint32_t& value) noexcept
+	{
+		size_t start = text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X') ? 2 : 0;
+		size_t end = !text.empty() && (text.back() == 'h' || text.back() == 'H') ? text.size() - 1 : text.size();
+		if (start >= end || end - start > 4) return false;
+
+		value = 0;
+		for (size_t i = start; i < end; ++i)
+		{
+			char c = text[i];
+			value <<= 4;
+			if (c >= '0' && c <= '9') value |= c - '0';
+			else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+			else return false;
+		}
+		return true;
+	}
+
+	//**********************************
+	// Get the value of a hex digit, or
+	// -1 when it isn't one
+	//**********************************
+	static inline int hex_digit(char c) noexcept
+	{
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+
+	//**********************************
+	// Stream a raw image
+	//**********************************
+	static void load_raw(i8080& cpu, std::ifstream& file, uint16_t offset, LoadResult& result)
+	{
+		// a small fixed block keeps the whole file from ever being
+		// held in memory twice
+		char block[4096];
+		uint32_t address = offset;
+		uint32_t size = cpu.get_memory_size();
+		while (address < size && file)
+		{
+			file.read(block, std::min<uint32_t>(sizeof(block), size - address));
+			size_t count = static_cast<size_t>(file.gcount());
+			cpu.load(static_cast<uint16_t>(address), reinterpret_cast<const uint8_t*>(block), count);
+			record(result, address, count);
+			address += static_cast<uint32_t>(count);
+		}
+	}
+
+	//**********************************
+	// Stream an Intel HEX image
+	//**********************************
+	static void load_hex(i8080& cpu, std::ifstream& file, LoadResult& result)
+	{
+		std::string line;
+		uint8_t bytes[5 + 255];
+		while (std::getline(file, line))
+		{
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty()) continue;
+			if (line[0] != ':' || line.size() < 11 || (line.size() - 1) % 2) throw -1;
+
+			// decode the whole record: count, address, type, data and
+			// checksum, which together add up to zero
+			size_t count = (line.size() - 1) / 2;
+			if (count > sizeof(bytes)) throw -1;
+			uint8_t sum = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				int high = hex_digit(line[1 + i * 2]);
+				int low = hex_digit(line[2 + i * 2]);
+				if (high < 0 || low < 0) throw -1;
+				bytes[i] = static_cast<uint8_t>((high << 4) | low);
+				sum += bytes[i];
+			}
+			if (sum != 0 || count != bytes[0] + 5u) throw -1;
+
+			uint16_t address = static_cast<uint16_t>((bytes[1] << 8) | bytes[2]);
+			const uint8_t* data = bytes + 4;
+			switch (bytes[3])
+			{
+			// data
+			case 0x00:
+				if (address + bytes[0] > cpu.get_memory_size()) throw -1;
+				cpu.load(address, data, bytes[0]);
+				record(result, address, bytes[0]);
+				break;
+			// end of file
+			case 0x01:
+				return;
+			// extended segment and linear addresses only make sense
+			// when they keep us in the bottom 64 KiB
+			case 0x02:
+			case 0x04:
+				if (bytes[0] != 2 || data[0] || data[1]) throw -1;
+				break;
+			// start segment (CS:IP) and start linear addresses
+			case 0x03:
+			case 0x05:
+				if (bytes[0] != 4) throw -1;
+				result.has_entry = true;
+				result.entry = static_cast<uint16_t>((data[2] << 8) | data[3]);
+				break;
+			default:
+				throw -1;
+			}
+		}
+	}
+
+	//**********************************
+	// Guess a format
+	//**********************************
+	ImageFormat guess_format(const std::string& filename) noexcept
+	{
+		size_t dot = filename.find_last_of('.');
+		if (dot == std::string::npos) return ImageFormat::Raw;
+		std::string extension = filename.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		if (extension == "hex" || extension == "ihx") return ImageFormat::IntelHex;
+		if (extension == "com") return ImageFormat::Com;
+		return ImageFormat::Raw;
+	}
+
+	//**********************************
+	// Load an image
+	//**********************************
+	LoadResult load_image(i8080& cpu, const std::string& filename, ImageFormat format, uint16_t offset)
+	{
+		std::ifstream file(filename, std::ios_base::binary);
+		if (!file.is_open()) throw -1;
+
+		LoadResult result;
+		switch (format)
+		{
+		case ImageFormat::Raw:
+			load_raw(cpu, file, offset, result);
+			break;
+		case ImageFormat::Com:
+			load_raw(cpu, file, 0x100, result);
+			result.has_entry = true;
+			result.entry = 0x100;
+			break;
+		case ImageFormat::IntelHex:
+			load_hex(cpu, file, result);
+			break;
+		}
+		return result;
+	}
+
+	//**********************************
+	// Load a manifest
+	//**********************************
+	LoadResult load_manifest(i8080& cpu, const std::string& filename)
+	{
+		std::ifstream manifest(filename);
+		if (!manifest.is_open()) throw -1;
+
+		size_t slash = filename.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+
+		LoadResult total;
+		std::string line;
+		while (std::getline(manifest, line))
+		{
+			std::istringstream fields(line.substr(0, line.find('#')));
+			std::string kind, name, where;
+			if (!(fields >> kind)) continue;
+
+			uint32_t address = 0;
+			if (kind == "entry")
+			{
+				if (!(fields >> where) || !parse_hex(where, address)) throw -1;
+				total.has_entry = true;
+				total.entry = static_cast<uint16_t>(address);
+				continue;
+			}
+
+			if (!(fields >> name)) throw -1;
+			ImageFormat format;
+			if (kind == "raw" || kind == "bin") format = ImageFormat::Raw;
+			else if (kind == "com") format = ImageFormat::Com;
+			else if (kind == "hex") format = ImageFormat::IntelHex;
+			else throw -1;
+			if (fields >> where && !parse_hex(where, address)) throw -1;
+
+			std::string path = !name.empty() && (name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos) ? name : directory + name;
+			LoadResult result = load_image(cpu, path, format, static_cast<uint16_t>(address));
+			total.low = std::min(total.low, result.low);
+			total.high = std::max(total.high, result.high);
+			total.bytes += result.bytes;
+			// an explicit entry line wins over one an image carries
+			if (result.has_entry && !total.has_entry)
+			{
+				total.has_entry = true;
+				total.entry = result.entry;
+			}
+		}
+		return total;
+	}
+}
@@ -0,0 +1,78 @@
+//**************************************
+// loader.h
+//
+// Holds the declaration of the image
+// loaders, which stream raw binaries,
+// CP/M .COM files and Intel HEX files
+// straight into the CPU's memory, and
+// of the manifest that lays several of
+// them out at once
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "i8080.h"
+
+namespace i8080
+{
+	enum class ImageFormat : uint8_t
+	{
+		// bytes loaded at an offset
+		Raw,
+		// a CP/M program, loaded and started at 0x100
+		Com,
+		// Intel HEX records, which carry their own addresses
+		IntelHex
+	};
+
+	// what a load put where
+	struct LoadResult
+	{
+		// the lowest and one past the highest address written
+		uint32_t low = UINT32_MAX;
+		uint32_t high = 0;
+		uint32_t bytes = 0;
+		// where to start, when the image says
+		bool has_entry = false;
+		uint16_t entry = 0;
+	};
+
+	//**********************************
+	// Pick a format from a file's
+	// extension (.hex/.ihx or .com,
+	// anything else is raw)
+	//**********************************
+	ImageFormat guess_format(const std::string& filename) noexcept;
+
+	//**********************************
+	// Stream an image into memory;
+	// offset is only used for raw
+	// images
+	//
+	// Throws -1 when the file can't be
+	// read or a HEX record is malformed
+	// or fails its checksum
+	//**********************************
+	LoadResult load_image(i8080& cpu, const std::string& filename, ImageFormat format, uint16_t offset = 0);
+
+	//**********************************
+	// Load every image a manifest
+	// lists, one per line as
+	//   raw file address
+	//   com file
+	//   hex file
+	//   entry address
+	// with # starting a comment, hex
+	// addresses and files relative to
+	// the manifest
+	//
+	// Throws -1 when the manifest or
+	// any image can't be loaded
+	//**********************************
+	LoadResult load_manifest(i8080& cpu, const std::string& filename);
+}
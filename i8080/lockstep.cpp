@@ -0,0 +1,111 @@
+//**************************************
+// lockstep.cpp
+//
+// Holds the definition of the lockstep
+// runner, which steps two CPUs through
+// the same program one instruction at a
+// time and stops at the first mismatch
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "lockstep.h"
+
+#include <cstring>
+
+#include "i8080.h"
+#include "trace_writer.h"
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	Lockstep::Lockstep(i8080& reference, i8080& candidate, uint64_t memory_interval) noexcept
+		: reference(reference), candidate(candidate), memory_interval(memory_interval ? memory_interval : 1)
+	{
+	}
+
+	//**********************************
+	// Step both CPUs together
+	//**********************************
+	Divergence Lockstep::run(uint64_t max_instructions)
+	{
+		Divergence divergence;
+		uint64_t end = instructions + max_instructions;
+
+		for (;;)
+		{
+			trace::Record a = trace::capture(reference);
+			trace::Record b = trace::capture(candidate);
+
+			int32_t address = -1;
+			if (instructions > 0) address = compare_writes(previous);
+			if (address < 0 && (instructions % memory_interval == 0 || instructions == end)) address = compare_memory();
+
+			if (address >= 0 || std::memcmp(&a, &b, sizeof(a)) != 0)
+			{
+				divergence.found = true;
+				divergence.index = instructions;
+				divergence.a = a;
+				divergence.b = b;
+				divergence.previous = previous;
+				divergence.address = address;
+				return divergence;
+			}
+			if (instructions == end) break;
+
+			previous = a;
+			bool alive_a = reference.single_step();
+			bool alive_b = candidate.single_step();
+			++instructions;
+			if (alive_a != alive_b)
+			{
+				divergence.found = true;
+				divergence.ended = true;
+				divergence.index = instructions;
+				divergence.a = trace::capture(reference);
+				divergence.b = trace::capture(candidate);
+				divergence.previous = previous;
+				return divergence;
+			}
+			if (!alive_a) break;
+		}
+		return divergence;
+	}
+
+	//**********************************
+	// Compare what could have changed
+	//**********************************
+	int32_t Lockstep::compare_writes(const trace::Record& before) const noexcept
+	{
+		// an instruction can only write through HL, BC, DE, a direct
+		// address (STA and SHLD) or just below where SP started, so
+		// checking those covers every write without decoding anything
+		uint16_t direct = before.operands[0] | (before.operands[1] << 8);
+		uint16_t sp = before.sp;
+		uint16_t addresses[9] = {
+			static_cast<uint16_t>((before.H << 8) | before.L),
+			static_cast<uint16_t>((before.B << 8) | before.C),
+			static_cast<uint16_t>((before.D << 8) | before.E),
+			direct, static_cast<uint16_t>(direct + 1),
+			sp, static_cast<uint16_t>(sp - 1), static_cast<uint16_t>(sp - 2), static_cast<uint16_t>(sp + 1) };
+
+		const uint8_t* a = reference.get_memory();
+		const uint8_t* b = candidate.get_memory();
+		uint32_t size = reference.get_memory_size() < candidate.get_memory_size() ? reference.get_memory_size() : candidate.get_memory_size();
+		for (uint16_t address : addresses)
+			if (address < size && a[address] != b[address]) return address;
+		return -1;
+	}
+
+	//**********************************
+	// Compare all of memory
+	//**********************************
+	int32_t Lockstep::compare_memory() const noexcept
+	{
+		uint32_t size = reference.get_memory_size() < candidate.get_memory_size() ? reference.get_memory_size() : candidate.get_memory_size();
+		size_t address = first_difference(reference.get_memory(), candidate.get_memory(), size);
+		return address < size ? static_cast<int32_t>(address) : -1;
+	}
+}
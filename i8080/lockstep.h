@@ -0,0 +1,77 @@
+//**************************************
+// lockstep.h
+//
+// Holds the declaration of the lockstep
+// runner, which steps two CPUs through
+// the same program one instruction at a
+// time and stops at the first mismatch
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+
+#include "divergence.h"
+
+namespace i8080
+{
+	class Lockstep final
+	{
+	public:
+		//******************************
+		// Constructor, takes the CPU
+		// that is trusted and the one
+		// being checked against it,
+		// both loaded with the same
+		// program and devices
+		//
+		// Every memory byte is compared
+		// once per memory_interval
+		// instructions, on top of the
+		// bytes each one could write
+		//******************************
+		Lockstep(i8080& reference, i8080& candidate, uint64_t memory_interval = 1 << 16) noexcept;
+
+		//******************************
+		// Step both CPUs until they
+		// mismatch in registers, flags,
+		// memory or cycle counts, or
+		// max_instructions go by
+		//
+		// Can be called again to carry
+		// on after a run with no mismatch
+		//******************************
+		Divergence run(uint64_t max_instructions);
+
+		//******************************
+		// Get the number of instructions
+		// both CPUs have agreed on
+		//******************************
+		inline uint64_t get_instructions() const noexcept { return instructions; }
+	private:
+		i8080& reference;
+		i8080& candidate;
+		uint64_t memory_interval;
+		uint64_t instructions = 0;
+		trace::Record previous{};
+
+		//******************************
+		// Compare the bytes the last
+		// instruction could have written
+		//
+		// Returns the first one that
+		// differs, or -1 if none do
+		//******************************
+		int32_t compare_writes(const trace::Record& before) const noexcept;
+
+		//******************************
+		// Compare all of memory
+		//
+		// Returns the first byte that
+		// differs, or -1 if none do
+		//******************************
+		int32_t compare_memory() const noexcept;
+	};
+}
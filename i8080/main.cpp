@@ -8,19 +8,120 @@
 // nathan.ikola@gmail.com
 //**************************************
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "static_warning.h"
 #include "disassembler.h"
+#include "divergence.h"
 #include "i8080.h"
+#include "listing_writer.h"
+#include "metrics_exporter.h"
+#include "runner.h"
+#include "trace_reader.h"
 
-int main()
+//**************************************
+// Decode a binary trace file, usage:
+//   --decode-trace file [first last [cycle]]
+// to only print PCs from first to last
+// (hex) starting at the given cycle
+//**************************************
+int decode_trace(int argc, char** argv)
+{
+	i8080::TraceReader reader(argv[2]);
+	uint16_t first = argc > 3 ? static_cast<uint16_t>(std::stoul(argv[3], nullptr, 16)) : 0x0000;
+	uint16_t last = argc > 4 ? static_cast<uint16_t>(std::stoul(argv[4], nullptr, 16)) : 0xFFFF;
+	size_t index = argc > 5 ? reader.seek_cycle(std::stoull(argv[5])) : 0;
+
+	while ((index = reader.find_pc(index, first, last)) < reader.size())
+		std::cout << i8080::TraceReader::Decode(reader[index++]) << '\n';
+	return 0;
+}
+
+//**************************************
+// Find where two binary trace files
+// diverge, usage:
+//   --diff-traces a b
+//**************************************
+int diff_traces(char** argv)
+{
+	i8080::TraceReader a(argv[2]);
+	i8080::TraceReader b(argv[3]);
+	i8080::Divergence divergence = i8080::find_divergence(a, b);
+	std::cout << i8080::describe(divergence);
+	return divergence.found ? 1 : 0;
+}
+
+//**************************************
+// Print what a metrics socket serves,
+// the way a scraper would see it, usage:
+//   --scrape socket
+//**************************************
+int scrape(const std::string& socket)
+{
+	std::cout << i8080::MetricsExporter::Scrape(socket);
+	return 0;
+}
+
+//**************************************
+// Raise the Space Invaders video
+// interrupts, RST 1 at mid screen and
+// RST 2 at the end of each frame
+//**************************************
+void video_interrupts(i8080::i8080& cpu, uint64_t at)
+{
+	// 2 MHz split into 120 half frames
+	const uint64_t half_frame = 2000000 / 120;
+	cpu.get_scheduler().schedule(at, [&cpu](uint64_t due)
+	{
+		cpu.interrupt((due / half_frame) & 1 ? 1 : 2);
+		video_interrupts(cpu, due + half_frame);
+	});
+}
+
+//**************************************
+// Run Space Invaders on its own thread
+// and serve its metrics on a socket
+// for --scrape to read, usage:
+//   --serve-metrics socket [seconds]
+//**************************************
+int serve_metrics(int argc, char** argv)
 {
-	i8080::Disassembler disassembler("cpudiag.bin", 0x100);
-	while (disassembler.HasContent())
+	i8080::i8080 cpu("invaders.bin");
+	video_interrupts(cpu, 2000000 / 120);
+
+	// the frame is the 7 KB of video memory at 0x2400
+	i8080::Runner runner(cpu, 0x2400, 0x1C00);
+	i8080::MetricsExporter exporter(runner, argv[2], i8080::MetricsExporter::Mode::Socket,
+		std::chrono::milliseconds(1000), "invaders");
+	runner.start();
+	exporter.start();
+
+	std::this_thread::sleep_for(std::chrono::seconds(argc > 3 ? std::stoul(argv[3]) : 60));
+	exporter.stop();
+	runner.stop();
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 2 && std::string(argv[1]) == "--decode-trace") return decode_trace(argc, argv);
+	if (argc > 3 && std::string(argv[1]) == "--diff-traces") return diff_traces(argv);
+	if (argc > 2 && std::string(argv[1]) == "--scrape") return scrape(argv[2]);
+	if (argc > 2 && std::string(argv[1]) == "--serve-metrics") return serve_metrics(argc, argv);
+
+	// the listing goes out in big blocks rather than flushing
+	// every line
 	{
-		string s = disassembler.GetLine();
-		std::cout << s << std::endl;
+		std::ifstream file("cpudiag.bin", std::ios::binary);
+		std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		i8080::ListingWriter listing(std::cout);
+		listing.write(image.data(), image.size(), 0x100);
 	}
 
 	i8080::i8080 cpu("cpudiag.bin", 0xFFFF, 0x100);
@@ -0,0 +1,73 @@
+//**************************************
+// mapped_file.cpp
+//
+// Holds the definition of a read-only
+// memory mapped file
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace i8080
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) throw -1;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size)) { CloseHandle(m_file); throw -1; }
+		m_size = static_cast<size_t>(size.QuadPart);
+		// an empty file can't be mapped, but it's still a valid file
+		if (m_size == 0) return;
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mapping) { CloseHandle(m_file); throw -1; }
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_data) { CloseHandle(m_mapping); CloseHandle(m_file); throw -1; }
+	}
+
+	MappedFile::~MappedFile() noexcept
+	{
+		if (m_data) UnmapViewOfFile(m_data);
+		if (m_mapping) CloseHandle(m_mapping);
+		if (m_file && m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	}
+#else
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) throw -1;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0) { close(fd); throw -1; }
+		m_size = static_cast<size_t>(info.st_size);
+		// an empty file can't be mapped, but it's still a valid file
+		if (m_size != 0)
+		{
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (data == MAP_FAILED) { close(fd); throw -1; }
+			m_data = static_cast<const uint8_t*>(data);
+		}
+		// the mapping stays valid after the descriptor is closed
+		close(fd);
+	}
+
+	MappedFile::~MappedFile() noexcept
+	{
+		if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+#endif
+}
@@ -0,0 +1,55 @@
+//**************************************
+// mapped_file.h
+//
+// Holds the declaration of a read-only
+// memory mapped file
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace i8080
+{
+	class MappedFile final
+	{
+	public:
+		//******************************
+		// Constructor, maps the whole
+		// file into memory
+		//
+		// Throws -1 when the file could
+		// not be opened or mapped
+		//******************************
+		MappedFile(const std::string& filename);
+
+		//******************************
+		// Destructor, unmaps the file
+		//******************************
+		~MappedFile() noexcept;
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//******************************
+		// Get the contents of the file
+		//******************************
+		inline const uint8_t* data() const noexcept { return m_data; }
+
+		//******************************
+		// Get the size of the file
+		//******************************
+		inline size_t size() const noexcept { return m_size; }
+	private:
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,105 @@
+//**************************************
+// metrics.cpp
+//
+// Holds the definition of the Prometheus
+// text form of the metrics the emulation
+// thread publishes
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace i8080
+{
+	//**********************************
+	// Write one metric's header
+	//**********************************
+	static void describe(std::ostream& out, const char* name, const char* type, const char* help)
+	{
+		out << "# HELP " << name << " " << help << "\n";
+		out << "# TYPE " << name << " " << type << "\n";
+	}
+
+	//**********************************
+	// Write nanoseconds as seconds
+	//**********************************
+	static void seconds(std::ostream& out, uint64_t ns)
+	{
+		// from whole nanoseconds rather than a double at the
+		// stream's precision, so long uptimes keep every digit
+		char text[32];
+		std::snprintf(text, sizeof(text), "%llu.%09llu",
+			static_cast<unsigned long long>(ns / 1000000000), static_cast<unsigned long long>(ns % 1000000000));
+		out << text;
+	}
+
+	//**********************************
+	// Escape a label value
+	//**********************************
+	static std::string escape(const std::string& value)
+	{
+		// the text format only needs backslash, quote and
+		// newline escaped inside a label value
+		std::string escaped;
+		escaped.reserve(value.size());
+		for (char c : value)
+		{
+			if (c == '\\') escaped += "\\\\";
+			else if (c == '"') escaped += "\\\"";
+			else if (c == '\n') escaped += "\\n";
+			else escaped += c;
+		}
+		return escaped;
+	}
+
+	//**********************************
+	// Write the metrics
+	//**********************************
+	void write_prometheus(std::ostream& out, const Metrics& metrics, const std::string& instance)
+	{
+		std::string value = escape(instance);
+		std::string labels = instance.empty() ? "" : "{instance=\"" + value + "\"}";
+		std::string quantile = instance.empty() ? "{quantile=\"" : "{instance=\"" + value + "\",quantile=\"";
+
+		describe(out, "i8080_instructions_total", "counter", "Guest instructions executed.");
+		out << "i8080_instructions_total" << labels << " " << metrics.instructions << "\n";
+		describe(out, "i8080_cycles_total", "counter", "Guest clock cycles emulated.");
+		out << "i8080_cycles_total" << labels << " " << metrics.cycles << "\n";
+		describe(out, "i8080_interrupts_total", "counter", "Interrupts accepted by the guest.");
+		out << "i8080_interrupts_total" << labels << " " << metrics.interrupts << "\n";
+		describe(out, "i8080_host_seconds_total", "counter", "Host time spent running the guest.");
+		out << "i8080_host_seconds_total" << labels << " ";
+		seconds(out, metrics.host_ns);
+		out << "\n";
+		describe(out, "i8080_emulated_mhz", "gauge", "Guest clock achieved over the last window, pacing included.");
+		out << "i8080_emulated_mhz" << labels << " " << metrics.mhz << "\n";
+		describe(out, "i8080_emulated_mips", "gauge", "Guest instructions per second over the last window, in millions.");
+		out << "i8080_emulated_mips" << labels << " " << metrics.mips << "\n";
+		describe(out, "i8080_unpaced_mhz", "gauge", "Guest clock the host could sustain without pacing.");
+		out << "i8080_unpaced_mhz" << labels << " " << metrics.run_mhz << "\n";
+		describe(out, "i8080_frame_bytes", "gauge", "Bytes of video memory snapshotted per frame.");
+		out << "i8080_frame_bytes" << labels << " " << metrics.frame_bytes << "\n";
+
+		// percentiles come from the most recent frames only, while
+		// the sum and count cover every frame since the start
+		std::array<uint32_t, Metrics::frame_window> sorted = metrics.frame_ns;
+		size_t count = static_cast<size_t>(std::min<uint64_t>(metrics.frames, Metrics::frame_window));
+		std::sort(sorted.begin(), sorted.begin() + count);
+		describe(out, "i8080_frame_seconds", "summary", "Host time spent running each frame.");
+		for (double q : { 0.5, 0.9, 0.99 })
+		{
+			uint32_t value = count ? sorted[std::min(count - 1, static_cast<size_t>(q * count))] : 0;
+			out << "i8080_frame_seconds" << quantile << q << "\"} ";
+			seconds(out, value);
+			out << "\n";
+		}
+		out << "i8080_frame_seconds_sum" << labels << " ";
+		seconds(out, metrics.host_ns);
+		out << "\n";
+		out << "i8080_frame_seconds_count" << labels << " " << metrics.frames << "\n";
+	}
+}
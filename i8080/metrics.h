@@ -0,0 +1,47 @@
+//**************************************
+// metrics.h
+//
+// Holds the declaration of the metrics
+// the emulation thread publishes each
+// frame, and their Prometheus text form
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace i8080
+{
+	// a copy of the host-side counters taken at the end of a frame
+	struct Metrics
+	{
+		// how many recent frame times are kept for the percentiles
+		static constexpr size_t frame_window = 128;
+
+		uint64_t instructions = 0;
+		uint64_t cycles = 0;
+		uint64_t interrupts = 0;
+		uint64_t frames = 0;
+		// host time spent running, in total and per recent frame
+		uint64_t host_ns = 0;
+		std::array<uint32_t, frame_window> frame_ns{};
+		// bytes copied out of video memory for each frame
+		uint32_t frame_bytes = 0;
+		// achieved and unpaced speeds over the monitor's window
+		double mhz = 0;
+		double mips = 0;
+		double run_mhz = 0;
+	};
+
+	//**********************************
+	// Write metrics in the Prometheus
+	// text exposition format, labelled
+	// with instance when it isn't empty
+	//**********************************
+	void write_prometheus(std::ostream& out, const Metrics& metrics, const std::string& instance = "");
+}
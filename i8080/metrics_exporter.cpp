@@ -0,0 +1,231 @@
+//**************************************
+// metrics_exporter.cpp
+//
+// Holds the definition of the exporter
+// that writes a runner's metrics out in
+// Prometheus text format, either to a
+// file or to whoever connects to a Unix
+// domain socket
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "metrics_exporter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+// Unix domain sockets come with Windows 10's Winsock, through afunix.h
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	MetricsExporter::MetricsExporter(Runner& runner, const std::string& path, Mode mode,
+		std::chrono::milliseconds interval, const std::string& instance)
+		: runner(runner), path(path), mode(mode), interval(interval), instance(instance)
+	{
+	}
+
+	// sockets are kept as an intptr_t so a Winsock SOCKET fits, and
+	// -1 means none on both (INVALID_SOCKET converts to it)
+#ifdef _WIN32
+	//**********************************
+	// Start Winsock, once per process
+	//**********************************
+	static bool sockets_ready() noexcept
+	{
+		static const bool ready = [] { WSADATA data; return WSAStartup(MAKEWORD(2, 2), &data) == 0; }();
+		return ready;
+	}
+
+	static inline SOCKET native(intptr_t socket) noexcept { return static_cast<SOCKET>(socket); }
+	static inline void close_socket(intptr_t socket) noexcept { closesocket(native(socket)); }
+
+	//**********************************
+	// Wait up to ms for a connection
+	//**********************************
+	static inline int wait_readable(intptr_t socket, int ms) noexcept
+	{
+		WSAPOLLFD waiting{ native(socket), POLLRDNORM, 0 };
+		return WSAPoll(&waiting, 1, ms);
+	}
+
+	static const int send_flags = 0;
+#else
+	static inline bool sockets_ready() noexcept { return true; }
+	static inline int native(intptr_t socket) noexcept { return static_cast<int>(socket); }
+	static inline void close_socket(intptr_t socket) noexcept { close(native(socket)); }
+
+	//**********************************
+	// Wait up to ms for a connection
+	//**********************************
+	static inline int wait_readable(intptr_t socket, int ms) noexcept
+	{
+		pollfd waiting{ native(socket), POLLIN, 0 };
+		return poll(&waiting, 1, ms);
+	}
+
+	// a scraper that hangs up early shouldn't kill us with SIGPIPE
+	static const int send_flags = MSG_NOSIGNAL;
+#endif
+
+	//**********************************
+	// Fill in a socket address
+	//**********************************
+	static bool socket_address(const std::string& path, sockaddr_un& address) noexcept
+	{
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(address.sun_path)) return false;
+		std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		return true;
+	}
+
+	//**********************************
+	// Start the exporting thread
+	//**********************************
+	void MetricsExporter::start()
+	{
+		if (thread.joinable()) return;
+		quit.store(false, std::memory_order_relaxed);
+
+		if (mode == Mode::File)
+		{
+			thread = std::thread(&MetricsExporter::write_files, this);
+			return;
+		}
+
+		sockaddr_un address;
+		if (!sockets_ready() || !socket_address(path, address)) throw -1;
+		listener = static_cast<intptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+		if (listener == -1) throw -1;
+		// a socket left behind by an earlier run would block the bind
+		std::remove(path.c_str());
+		if (bind(native(listener), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(native(listener), 8) != 0)
+		{
+			close_socket(listener);
+			listener = -1;
+			throw -1;
+		}
+		thread = std::thread(&MetricsExporter::serve, this);
+	}
+
+	//**********************************
+	// Answer scrapes on the socket
+	//**********************************
+	void MetricsExporter::serve()
+	{
+		// wake up every interval to notice stop() even if nobody
+		// ever connects
+		while (!quit.load(std::memory_order_relaxed))
+		{
+			if (wait_readable(listener, static_cast<int>(interval.count())) <= 0) continue;
+			intptr_t client = static_cast<intptr_t>(accept(native(listener), nullptr, nullptr));
+			if (client == -1) continue;
+
+			std::string text = format();
+			const char* data = text.data();
+			size_t left = text.size();
+			while (left > 0)
+			{
+				auto sent = send(native(client), data, static_cast<int>(left), send_flags);
+				if (sent <= 0) break;
+				data += sent;
+				left -= static_cast<size_t>(sent);
+			}
+			close_socket(client);
+		}
+
+		close_socket(listener);
+		listener = -1;
+		std::remove(path.c_str());
+	}
+
+	//**********************************
+	// Scrape a metrics socket
+	//**********************************
+	std::string MetricsExporter::Scrape(const std::string& path)
+	{
+		sockaddr_un address;
+		if (!sockets_ready() || !socket_address(path, address)) throw -1;
+		intptr_t connection = static_cast<intptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+		if (connection == -1) throw -1;
+		if (connect(native(connection), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			close_socket(connection);
+			throw -1;
+		}
+
+		// the exporter closes the connection once it has sent everything
+		std::string text;
+		char buffer[4096];
+		int got;
+		while ((got = static_cast<int>(recv(native(connection), buffer, sizeof(buffer), 0))) > 0)
+			text.append(buffer, static_cast<size_t>(got));
+		close_socket(connection);
+		return text;
+	}
+
+	//**********************************
+	// Stop the exporting thread
+	//**********************************
+	void MetricsExporter::stop()
+	{
+		quit.store(true, std::memory_order_relaxed);
+		if (thread.joinable()) thread.join();
+	}
+
+	//**********************************
+	// Format the newest metrics
+	//**********************************
+	std::string MetricsExporter::format()
+	{
+		// the runner hands metrics over through a triple buffer, so
+		// this never makes the emulation thread wait, and copies them
+		// out so several exporters can share it
+		std::ostringstream text;
+		write_prometheus(text, runner.copy_metrics(), instance);
+		return text.str();
+	}
+
+	//**********************************
+	// Rewrite the metrics file
+	//**********************************
+	void MetricsExporter::write_files()
+	{
+		std::string temporary = path + ".tmp";
+		while (!quit.load(std::memory_order_relaxed))
+		{
+			{
+				std::ofstream file(temporary, std::ios::trunc);
+				file << format();
+			}
+#ifdef _WIN32
+			// rename only replaces an existing file on POSIX
+			std::remove(path.c_str());
+#endif
+			std::rename(temporary.c_str(), path.c_str());
+			std::this_thread::sleep_for(interval);
+		}
+	}
+}
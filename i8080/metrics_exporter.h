@@ -0,0 +1,96 @@
+//**************************************
+// metrics_exporter.h
+//
+// Holds the declaration of the exporter
+// that writes a runner's metrics out in
+// Prometheus text format, either to a
+// file or to whoever connects to a Unix
+// domain socket
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "runner.h"
+
+namespace i8080
+{
+	class MetricsExporter final
+	{
+	public:
+		enum class Mode : uint8_t
+		{
+			// rewrite path every interval (written beside it and
+			// renamed, so readers never see half a file)
+			File,
+			// listen on a Unix domain socket at path and answer each
+			// connection with the current metrics
+			Socket
+		};
+
+		//******************************
+		// Constructor, takes the runner
+		// to export, where to put the
+		// metrics and how often to check
+		// for new ones
+		//******************************
+		MetricsExporter(Runner& runner, const std::string& path, Mode mode = Mode::File,
+			std::chrono::milliseconds interval = std::chrono::milliseconds(1000), const std::string& instance = "");
+
+		//******************************
+		// Destructor, stops the thread
+		//******************************
+		inline ~MetricsExporter() { stop(); }
+
+		//******************************
+		// Start the exporting thread
+		//
+		// Throws if the socket can't be
+		// opened (Windows needs 10 or
+		// later for Unix sockets)
+		//******************************
+		void start();
+
+		//******************************
+		// Stop the exporting thread and
+		// wait for it to finish
+		//******************************
+		void stop();
+
+		//******************************
+		// Connect to a metrics socket
+		// the way a scraper would and
+		// return what it sent
+		//******************************
+		static std::string Scrape(const std::string& path);
+	private:
+		Runner& runner;
+		std::string path;
+		Mode mode;
+		std::chrono::milliseconds interval;
+		std::string instance;
+
+		std::thread thread;
+		std::atomic<bool> quit{ false };
+		// the listening socket, -1 when there isn't one
+		intptr_t listener = -1;
+
+		//******************************
+		// Format the newest metrics
+		//******************************
+		std::string format();
+
+		//******************************
+		// The exporting thread's loops
+		//******************************
+		void write_files();
+		void serve();
+	};
+}
@@ -9,283 +9,305 @@
 //**************************************
 #pragma once
 
-#include <string>
-using std::string;
+#include <cstdint>
+#include <string_view>
 
 namespace i8080
 {
-    string mnemonics[256]
+    // what follows the opcode, and so how it gets printed
+    enum class OperandFormat : uint8_t
     {
-        "NOP",
-        "LXI     B, ",
-        "STAX    B",
-        "INX     B",
-        "INR     B",
-        "DCR     B",
-        "MVI     B, ",
-        "RLC",   
-        "NOP",   
-        "DAD     B",
-        "LDAX    B",
-        "DCX     B",
-        "INR     C",
-        "DCR     C",
-        "MVI     C, ",
-        "RRC",   
-                 
-        "NOP",   
-        "LXI     D, ",
-        "STAX    D",
-        "INX     D",
-        "INR     D",
-        "DCR     D",
-        "MVI     D, ",
-        "RAL",   
-        "NOP",   
-        "DAD     D",
-        "LDAX    D",
-        "DCX     D",
-        "INR     E",
-        "DCR     E",
-        "MVI     E, ",
-        "RAR",   
-                 
-        "NOP",   
-        "LXI     H, ",
-        "SHLD",  
-        "INX     H",
-        "INR     H",
-        "DCR     H",
-        "MVI     H, ",
-        "DAA",   
-        "NOP",   
-        "DAD     H",
-        "LHLD",  
-        "DCX     H",
-        "INR     L",
-        "DCR     L",
-        "MVI     L, ",
-        "CMA",   
-                 
-        "NOP",   
-        "LXI     SP, ",
-        "STA",   
-        "INX     SP",
-        "INR     M",
-        "DCR     M",
-        "MVI     M, ",
-        "STC",   
-        "NOP",   
-        "DAD     SP",
-        "LDA",   
-        "DCX     SP",
-        "INR     A",
-        "DCR     A",
-        "MVI     A, ",
-        "CMC",   
-                 
-        "MOV     B,B",
-        "MOV     B,C",
-        "MOV     B,D",
-        "MOV     B,E",
-        "MOV     B,H",
-        "MOV     B,L",
-        "MOV     B,M",
-        "MOV     B,A",
-        "MOV     C,B",
-        "MOV     C,C",
-        "MOV     C,D",
-        "MOV     C,E",
-        "MOV     C,H",
-        "MOV     C,L",
-        "MOV     C,M",
-        "MOV     C,A",
-                 
-        "MOV     D,B",
-        "MOV     D,C",
-        "MOV     D,D",
-        "MOV     D,E",
-        "MOV     D,H",
-        "MOV     D,L",
-        "MOV     D,M",
-        "MOV     D,A",
-        "MOV     E,B",
-        "MOV     E,C",
-        "MOV     E,D",
-        "MOV     E,E",
-        "MOV     E,H",
-        "MOV     E,L",
-        "MOV     E,M",
-        "MOV     E,A",
-                 
-        "MOV     H,B",
-        "MOV     H,C",
-        "MOV     H,D",
-        "MOV     H,E",
-        "MOV     H,H",
-        "MOV     H,L",
-        "MOV     H,M",
-        "MOV     H,A",
-        "MOV     L,B",
-        "MOV     L,C",
-        "MOV     L,D",
-        "MOV     L,E",
-        "MOV     L,H",
-        "MOV     L,L",
-        "MOV     L,M",
-        "MOV     L,A",
-                 
-        "MOV     M,B",
-        "MOV     M,C",
-        "MOV     M,D",
-        "MOV     M,E",
-        "MOV     M,H",
-        "MOV     M,L",
-        "MOV     M,M",
-        "MOV     M,A",
-        "MOV     A,B",
-        "MOV     A,C",
-        "MOV     A,D",
-        "MOV     A,E",
-        "MOV     A,H",
-        "MOV     A,L",
-        "MOV     A,M",
-        "MOV     A,A",
-                 
-        "ADD     B",
-        "ADD     C",
-        "ADD     D",
-        "ADD     E",
-        "ADD     H",
-        "ADD     L",
-        "ADD     M",
-        "ADD     A",
-        "ADC     B",
-        "ADC     C",
-        "ADC     D",
-        "ADC     E",
-        "ADC     H",
-        "ADC     L",
-        "ADC     M",
-        "ADC     A",
-                 
-        "SUB     B",
-        "SUB     C",
-        "SUB     D",
-        "SUB     E",
-        "SUB     H",
-        "SUB     L",
-        "SUB     M",
-        "SUB     A",
-        "SBB     B",
-        "SBB     C",
-        "SBB     D",
-        "SBB     E",
-        "SBB     H",
-        "SBB     L",
-        "SBB     M",
-        "SBB     A",
-                 
-        "ANA     B",
-        "ANA     C",
-        "ANA     D",
-        "ANA     E",
-        "ANA     H",
-        "ANA     L",
-        "ANA     M",
-        "ANA     A",
-        "XRA     B",
-        "XRA     C",
-        "XRA     D",
-        "XRA     E",
-        "XRA     H",
-        "XRA     L",
-        "XRA     M",
-        "XRA     A",
-                 
-        "ORA     B",
-        "ORA     C",
-        "ORA     D",
-        "ORA     E",
-        "ORA     H",
-        "ORA     L",
-        "ORA     M",
-        "ORA     A",
-        "CMP     B",
-        "CMP     C",
-        "CMP     D",
-        "CMP     E",
-        "CMP     H",
-        "CMP     L",
-        "CMP     M",
-        "CMP     A",
-                 
-        "RNZ",   
-        "POP     B",
-        "JNZ",   
-        "JMP",   
-        "CNZ",   
-        "PUSH    B",
-        "ADI",   
-        "RST     0",
-        "RZ",    
-        "RET",   
-        "JZ",    
-        "JMP",   
-        "CZ",    
-        "CALL",  
-        "ACI",   
-        "RST     1",
-                 
-        "RNC",   
-        "POP     D",
-        "JNC",   
-        "OUT",   
-        "CNC",   
-        "PUSH    D",
-        "SUI",   
-        "RST     2",
-        "RC",    
-        "RET",   
-        "JC",    
-        "IN",    
-        "CC",    
-        "CALL",  
-        "SBI",   
-        "RST     3",
-                 
-        "RPO",   
-        "POP     H",
-        "JPO",   
-        "XTHL",  
-        "CPO",   
-        "PUSH    H",
-        "ANI",   
-        "RST     4",
-        "RPE",   
-        "PCHL",  
-        "JPE",   
-        "XCHG",  
-        "CPE",   
-        "CALL",  
-        "XRI",   
-        "RST     5",
-                 
-        "RP",    
-        "POP     PSW",
-        "JP",    
-        "DI",    
-        "CP",    
-        "PUSH    PSW",
-        "ORI",   
-        "RST     6",
-        "RM",    
-        "SPHL",  
-        "JM",    
-        "EI",    
-        "CM",    
-        "CALL",  
-        "CPI",   
-        "RST     7",
+        None,
+        // an 8 bit immediate or port
+        Byte,
+        // a 16 bit immediate or address
+        Word
     };
-}
\ No newline at end of file
+
+    // an opcode's mnemonic, its fixed register operands and
+    // the format of any immediate after it
+    struct MnemonicInfo
+    {
+        std::string_view name;
+        std::string_view operands;
+        OperandFormat format;
+    };
+
+    // built at compile time, so including this anywhere costs
+    // nothing at startup and can't be defined twice
+    inline constexpr MnemonicInfo mnemonics[256]
+    {
+        // 0x
+        { "NOP", "", OperandFormat::None },
+        { "LXI", "B", OperandFormat::Word },
+        { "STAX", "B", OperandFormat::None },
+        { "INX", "B", OperandFormat::None },
+        { "INR", "B", OperandFormat::None },
+        { "DCR", "B", OperandFormat::None },
+        { "MVI", "B", OperandFormat::Byte },
+        { "RLC", "", OperandFormat::None },
+        { "NOP", "", OperandFormat::None },
+        { "DAD", "B", OperandFormat::None },
+        { "LDAX", "B", OperandFormat::None },
+        { "DCX", "B", OperandFormat::None },
+        { "INR", "C", OperandFormat::None },
+        { "DCR", "C", OperandFormat::None },
+        { "MVI", "C", OperandFormat::Byte },
+        { "RRC", "", OperandFormat::None },
+        // 1x
+        { "NOP", "", OperandFormat::None },
+        { "LXI", "D", OperandFormat::Word },
+        { "STAX", "D", OperandFormat::None },
+        { "INX", "D", OperandFormat::None },
+        { "INR", "D", OperandFormat::None },
+        { "DCR", "D", OperandFormat::None },
+        { "MVI", "D", OperandFormat::Byte },
+        { "RAL", "", OperandFormat::None },
+        { "NOP", "", OperandFormat::None },
+        { "DAD", "D", OperandFormat::None },
+        { "LDAX", "D", OperandFormat::None },
+        { "DCX", "D", OperandFormat::None },
+        { "INR", "E", OperandFormat::None },
+        { "DCR", "E", OperandFormat::None },
+        { "MVI", "E", OperandFormat::Byte },
+        { "RAR", "", OperandFormat::None },
+        // 2x
+        { "NOP", "", OperandFormat::None },
+        { "LXI", "H", OperandFormat::Word },
+        { "SHLD", "", OperandFormat::Word },
+        { "INX", "H", OperandFormat::None },
+        { "INR", "H", OperandFormat::None },
+        { "DCR", "H", OperandFormat::None },
+        { "MVI", "H", OperandFormat::Byte },
+        { "DAA", "", OperandFormat::None },
+        { "NOP", "", OperandFormat::None },
+        { "DAD", "H", OperandFormat::None },
+        { "LHLD", "", OperandFormat::Word },
+        { "DCX", "H", OperandFormat::None },
+        { "INR", "L", OperandFormat::None },
+        { "DCR", "L", OperandFormat::None },
+        { "MVI", "L", OperandFormat::Byte },
+        { "CMA", "", OperandFormat::None },
+        // 3x
+        { "NOP", "", OperandFormat::None },
+        { "LXI", "SP", OperandFormat::Word },
+        { "STA", "", OperandFormat::Word },
+        { "INX", "SP", OperandFormat::None },
+        { "INR", "M", OperandFormat::None },
+        { "DCR", "M", OperandFormat::None },
+        { "MVI", "M", OperandFormat::Byte },
+        { "STC", "", OperandFormat::None },
+        { "NOP", "", OperandFormat::None },
+        { "DAD", "SP", OperandFormat::None },
+        { "LDA", "", OperandFormat::Word },
+        { "DCX", "SP", OperandFormat::None },
+        { "INR", "A", OperandFormat::None },
+        { "DCR", "A", OperandFormat::None },
+        { "MVI", "A", OperandFormat::Byte },
+        { "CMC", "", OperandFormat::None },
+        // 4x
+        { "MOV", "B,B", OperandFormat::None },
+        { "MOV", "B,C", OperandFormat::None },
+        { "MOV", "B,D", OperandFormat::None },
+        { "MOV", "B,E", OperandFormat::None },
+        { "MOV", "B,H", OperandFormat::None },
+        { "MOV", "B,L", OperandFormat::None },
+        { "MOV", "B,M", OperandFormat::None },
+        { "MOV", "B,A", OperandFormat::None },
+        { "MOV", "C,B", OperandFormat::None },
+        { "MOV", "C,C", OperandFormat::None },
+        { "MOV", "C,D", OperandFormat::None },
+        { "MOV", "C,E", OperandFormat::None },
+        { "MOV", "C,H", OperandFormat::None },
+        { "MOV", "C,L", OperandFormat::None },
+        { "MOV", "C,M", OperandFormat::None },
+        { "MOV", "C,A", OperandFormat::None },
+        // 5x
+        { "MOV", "D,B", OperandFormat::None },
+        { "MOV", "D,C", OperandFormat::None },
+        { "MOV", "D,D", OperandFormat::None },
+        { "MOV", "D,E", OperandFormat::None },
+        { "MOV", "D,H", OperandFormat::None },
+        { "MOV", "D,L", OperandFormat::None },
+        { "MOV", "D,M", OperandFormat::None },
+        { "MOV", "D,A", OperandFormat::None },
+        { "MOV", "E,B", OperandFormat::None },
+        { "MOV", "E,C", OperandFormat::None },
+        { "MOV", "E,D", OperandFormat::None },
+        { "MOV", "E,E", OperandFormat::None },
+        { "MOV", "E,H", OperandFormat::None },
+        { "MOV", "E,L", OperandFormat::None },
+        { "MOV", "E,M", OperandFormat::None },
+        { "MOV", "E,A", OperandFormat::None },
+        // 6x
+        { "MOV", "H,B", OperandFormat::None },
+        { "MOV", "H,C", OperandFormat::None },
+        { "MOV", "H,D", OperandFormat::None },
+        { "MOV", "H,E", OperandFormat::None },
+        { "MOV", "H,H", OperandFormat::None },
+        { "MOV", "H,L", OperandFormat::None },
+        { "MOV", "H,M", OperandFormat::None },
+        { "MOV", "H,A", OperandFormat::None },
+        { "MOV", "L,B", OperandFormat::None },
+        { "MOV", "L,C", OperandFormat::None },
+        { "MOV", "L,D", OperandFormat::None },
+        { "MOV", "L,E", OperandFormat::None },
+        { "MOV", "L,H", OperandFormat::None },
+        { "MOV", "L,L", OperandFormat::None },
+        { "MOV", "L,M", OperandFormat::None },
+        { "MOV", "L,A", OperandFormat::None },
+        // 7x
+        { "MOV", "M,B", OperandFormat::None },
+        { "MOV", "M,C", OperandFormat::None },
+        { "MOV", "M,D", OperandFormat::None },
+        { "MOV", "M,E", OperandFormat::None },
+        { "MOV", "M,H", OperandFormat::None },
+        { "MOV", "M,L", OperandFormat::None },
+        { "HLT", "", OperandFormat::None },
+        { "MOV", "M,A", OperandFormat::None },
+        { "MOV", "A,B", OperandFormat::None },
+        { "MOV", "A,C", OperandFormat::None },
+        { "MOV", "A,D", OperandFormat::None },
+        { "MOV", "A,E", OperandFormat::None },
+        { "MOV", "A,H", OperandFormat::None },
+        { "MOV", "A,L", OperandFormat::None },
+        { "MOV", "A,M", OperandFormat::None },
+        { "MOV", "A,A", OperandFormat::None },
+        // 8x
+        { "ADD", "B", OperandFormat::None },
+        { "ADD", "C", OperandFormat::None },
+        { "ADD", "D", OperandFormat::None },
+        { "ADD", "E", OperandFormat::None },
+        { "ADD", "H", OperandFormat::None },
+        { "ADD", "L", OperandFormat::None },
+        { "ADD", "M", OperandFormat::None },
+        { "ADD", "A", OperandFormat::None },
+        { "ADC", "B", OperandFormat::None },
+        { "ADC", "C", OperandFormat::None },
+        { "ADC", "D", OperandFormat::None },
+        { "ADC", "E", OperandFormat::None },
+        { "ADC", "H", OperandFormat::None },
+        { "ADC", "L", OperandFormat::None },
+        { "ADC", "M", OperandFormat::None },
+        { "ADC", "A", OperandFormat::None },
+        // 9x
+        { "SUB", "B", OperandFormat::None },
+        { "SUB", "C", OperandFormat::None },
+        { "SUB", "D", OperandFormat::None },
+        { "SUB", "E", OperandFormat::None },
+        { "SUB", "H", OperandFormat::None },
+        { "SUB", "L", OperandFormat::None },
+        { "SUB", "M", OperandFormat::None },
+        { "SUB", "A", OperandFormat::None },
+        { "SBB", "B", OperandFormat::None },
+        { "SBB", "C", OperandFormat::None },
+        { "SBB", "D", OperandFormat::None },
+        { "SBB", "E", OperandFormat::None },
+        { "SBB", "H", OperandFormat::None },
+        { "SBB", "L", OperandFormat::None },
+        { "SBB", "M", OperandFormat::None },
+        { "SBB", "A", OperandFormat::None },
+        // Ax
+        { "ANA", "B", OperandFormat::None },
+        { "ANA", "C", OperandFormat::None },
+        { "ANA", "D", OperandFormat::None },
+        { "ANA", "E", OperandFormat::None },
+        { "ANA", "H", OperandFormat::None },
+        { "ANA", "L", OperandFormat::None },
+        { "ANA", "M", OperandFormat::None },
+        { "ANA", "A", OperandFormat::None },
+        { "XRA", "B", OperandFormat::None },
+        { "XRA", "C", OperandFormat::None },
+        { "XRA", "D", OperandFormat::None },
+        { "XRA", "E", OperandFormat::None },
+        { "XRA", "H", OperandFormat::None },
+        { "XRA", "L", OperandFormat::None },
+        { "XRA", "M", OperandFormat::None },
+        { "XRA", "A", OperandFormat::None },
+        // Bx
+        { "ORA", "B", OperandFormat::None },
+        { "ORA", "C", OperandFormat::None },
+        { "ORA", "D", OperandFormat::None },
+        { "ORA", "E", OperandFormat::None },
+        { "ORA", "H", OperandFormat::None },
+        { "ORA", "L", OperandFormat::None },
+        { "ORA", "M", OperandFormat::None },
+        { "ORA", "A", OperandFormat::None },
+        { "CMP", "B", OperandFormat::None },
+        { "CMP", "C", OperandFormat::None },
+        { "CMP", "D", OperandFormat::None },
+        { "CMP", "E", OperandFormat::None },
+        { "CMP", "H", OperandFormat::None },
+        { "CMP", "L", OperandFormat::None },
+        { "CMP", "M", OperandFormat::None },
+        { "CMP", "A", OperandFormat::None },
+        // Cx
+        { "RNZ", "", OperandFormat::None },
+        { "POP", "B", OperandFormat::None },
+        { "JNZ", "", OperandFormat::Word },
+        { "JMP", "", OperandFormat::Word },
+        { "CNZ", "", OperandFormat::Word },
+        { "PUSH", "B", OperandFormat::None },
+        { "ADI", "", OperandFormat::Byte },
+        { "RST", "0", OperandFormat::None },
+        { "RZ", "", OperandFormat::None },
+        { "RET", "", OperandFormat::None },
+        { "JZ", "", OperandFormat::Word },
+        { "JMP", "", OperandFormat::Word },
+        { "CZ", "", OperandFormat::Word },
+        { "CALL", "", OperandFormat::Word },
+        { "ACI", "", OperandFormat::Byte },
+        { "RST", "1", OperandFormat::None },
+        // Dx
+        { "RNC", "", OperandFormat::None },
+        { "POP", "D", OperandFormat::None },
+        { "JNC", "", OperandFormat::Word },
+        { "OUT", "", OperandFormat::Byte },
+        { "CNC", "", OperandFormat::Word },
+        { "PUSH", "D", OperandFormat::None },
+        { "SUI", "", OperandFormat::Byte },
+        { "RST", "2", OperandFormat::None },
+        { "RC", "", OperandFormat::None },
+        { "RET", "", OperandFormat::None },
+        { "JC", "", OperandFormat::Word },
+        { "IN", "", OperandFormat::Byte },
+        { "CC", "", OperandFormat::Word },
+        { "CALL", "", OperandFormat::Word },
+        { "SBI", "", OperandFormat::Byte },
+        { "RST", "3", OperandFormat::None },
+        // Ex
+        { "RPO", "", OperandFormat::None },
+        { "POP", "H", OperandFormat::None },
+        { "JPO", "", OperandFormat::Word },
+        { "XTHL", "", OperandFormat::None },
+        { "CPO", "", OperandFormat::Word },
+        { "PUSH", "H", OperandFormat::None },
+        { "ANI", "", OperandFormat::Byte },
+        { "RST", "4", OperandFormat::None },
+        { "RPE", "", OperandFormat::None },
+        { "PCHL", "", OperandFormat::None },
+        { "JPE", "", OperandFormat::Word },
+        { "XCHG", "", OperandFormat::None },
+        { "CPE", "", OperandFormat::Word },
+        { "CALL", "", OperandFormat::Word },
+        { "XRI", "", OperandFormat::Byte },
+        { "RST", "5", OperandFormat::None },
+        // Fx
+        { "RP", "", OperandFormat::None },
+        { "POP", "PSW", OperandFormat::None },
+        { "JP", "", OperandFormat::Word },
+        { "DI", "", OperandFormat::None },
+        { "CP", "", OperandFormat::Word },
+        { "PUSH", "PSW", OperandFormat::None },
+        { "ORI", "", OperandFormat::Byte },
+        { "RST", "6", OperandFormat::None },
+        { "RM", "", OperandFormat::None },
+        { "SPHL", "", OperandFormat::None },
+        { "JM", "", OperandFormat::Word },
+        { "EI", "", OperandFormat::None },
+        { "CM", "", OperandFormat::Word },
+        { "CALL", "", OperandFormat::Word },
+        { "CPI", "", OperandFormat::Byte },
+        { "RST", "7", OperandFormat::None },
+    };
+}
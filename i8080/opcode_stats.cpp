@@ -0,0 +1,75 @@
+//**************************************
+// opcode_stats.cpp
+//
+// Holds the definition of the dump of
+// the per-opcode execution and cycle
+// counters
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "opcode_stats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "disassembler.h"
+#include "i8080.h"
+
+namespace i8080
+{
+	//**********************************
+	// Write the opcode counters
+	//**********************************
+	void write_opcode_stats(const i8080& cpu, std::ostream& out, bool json)
+	{
+		const std::array<uint64_t, 256>& counts = cpu.get_opcode_counts();
+		const std::array<uint64_t, 256>& cycles = cpu.get_opcode_cycles();
+
+		// only list opcodes that ran, the most expensive first
+		std::vector<uint8_t> ops;
+		uint64_t total = 0;
+		for (int op = 0; op < 256; ++op)
+		{
+			if (counts[op] == 0) continue;
+			ops.push_back(static_cast<uint8_t>(op));
+			total += cycles[op];
+		}
+		std::sort(ops.begin(), ops.end(), [&](uint8_t a, uint8_t b) { return cycles[a] != cycles[b] ? cycles[a] > cycles[b] : a < b; });
+
+		// the caller's stream gets its formatting back afterwards
+		std::ios_base::fmtflags flags = out.flags();
+		std::streamsize precision = out.precision();
+		char fill = out.fill();
+
+		if (json)
+		{
+			// plain decimal whatever the caller left set, or the
+			// numbers aren't valid JSON
+			out.flags(std::ios_base::dec);
+			out << "[";
+			for (size_t i = 0; i < ops.size(); ++i)
+			{
+				uint8_t op = ops[i];
+				out << (i ? ",\n " : "\n ") << "{\"opcode\":" << +op << ",\"mnemonic\":\"" << Disassembler::Mnemonic(op)
+					<< "\",\"count\":" << counts[op] << ",\"cycles\":" << cycles[op] << "}";
+			}
+			out << "\n]\n";
+			out.flags(flags);
+			return;
+		}
+
+		out << "opcode  mnemonic            count          cycles  cycles%\n";
+		for (uint8_t op : ops)
+		{
+			out << "0x" << std::hex << std::setfill('0') << std::setw(2) << +op << std::dec << std::setfill(' ')
+				<< "    " << std::setw(12) << std::left << Disassembler::Mnemonic(op) << std::right
+				<< std::setw(13) << counts[op] << std::setw(16) << cycles[op]
+				<< std::setw(8) << std::fixed << std::setprecision(2) << (total ? 100.0 * cycles[op] / total : 0.0) << "%\n";
+		}
+		out.flags(flags);
+		out.precision(precision);
+		out.fill(fill);
+	}
+}
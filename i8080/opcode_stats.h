@@ -0,0 +1,26 @@
+//**************************************
+// opcode_stats.h
+//
+// Holds the declaration of the dump of
+// the per-opcode execution and cycle
+// counters
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <ostream>
+
+namespace i8080
+{
+	class i8080;
+
+	//**********************************
+	// Write the opcode counters of a
+	// CPU with their mnemonics, busiest
+	// first, as a text table or as a
+	// JSON array
+	//**********************************
+	void write_opcode_stats(const i8080& cpu, std::ostream& out, bool json = false);
+}
@@ -0,0 +1,71 @@
+//**************************************
+// pacer.cpp
+//
+// Holds the definition of the pacer
+// that runs the emulation in real time
+// at a fixed clock rate
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "pacer.h"
+
+#include <thread>
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	Pacer::Pacer(i8080& cpu, uint32_t frequency, uint32_t frame_rate)
+		: cpu(cpu), frequency(frequency), frame_rate(frame_rate)
+	{
+		// every frame's targets are divided by the frame rate
+		if (frame_rate == 0) throw -1;
+		resync();
+	}
+
+	//**********************************
+	// Restart the frame deadlines
+	//**********************************
+	void Pacer::resync() noexcept
+	{
+		start_time = clock::now();
+		start_cycle = cpu.get_cycles();
+		frame = 0;
+	}
+
+	//**********************************
+	// Run one paced frame
+	//**********************************
+	bool Pacer::run_frame()
+	{
+		using namespace std::chrono;
+
+		++frame;
+		// exact cycle and time targets for the end of this frame
+		uint64_t target = start_cycle + frame * frequency / frame_rate;
+		clock::time_point due = start_time + duration_cast<clock::duration>(nanoseconds(frame * 1000000000ull / frame_rate));
+
+		bool running = cpu.run_until(target);
+		++frames;
+
+		clock::time_point now = clock::now();
+		double period = 1.0 / frame_rate;
+		double spare = duration<double>(due - now).count() / period;
+
+		// keep a rolling average so a single slow frame doesn't swing it
+		headroom += ((spare > 0 ? spare : 0) - headroom) / 16;
+
+		if (now > due + duration_cast<clock::duration>(nanoseconds(max_lag * 1000000000ull / frame_rate)))
+		{
+			// we are too far behind to catch up, so drop the
+			// backlog instead of running flat out to make it up
+			++resyncs;
+			resync();
+		}
+		else if (now < due) std::this_thread::sleep_until(due);
+
+		return running;
+	}
+}
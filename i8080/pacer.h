@@ -0,0 +1,95 @@
+//**************************************
+// pacer.h
+//
+// Holds the declaration of the pacer
+// that runs the emulation in real time
+// at a fixed clock rate
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "i8080.h"
+
+namespace i8080
+{
+	class Pacer final
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		//******************************
+		// Constructor, takes the CPU to
+		// pace along with its clock
+		// rate and how many frames a
+		// second to split it into
+		//
+		// Throws -1 when frame_rate is 0
+		//******************************
+		Pacer(i8080& cpu, uint32_t frequency = 2000000, uint32_t frame_rate = 60);
+
+		//******************************
+		// Run one frame's worth of
+		// cycles then sleep until the
+		// frame is due to end
+		//
+		// Returns false when the CPU
+		// stopped and can never resume
+		//******************************
+		bool run_frame();
+
+		//******************************
+		// Run paced frames until the
+		// CPU stops
+		//******************************
+		inline void run() { while (run_frame()); }
+
+		//******************************
+		// Get the fraction of each frame
+		// spent sleeping (averaged over
+		// recent frames), 0 means there
+		// is no time to spare
+		//******************************
+		inline double get_headroom() const noexcept { return headroom; }
+
+		//******************************
+		// Get the number of frames run
+		//******************************
+		inline uint64_t get_frames() const noexcept { return frames; }
+
+		//******************************
+		// Get the number of times we
+		// fell too far behind and had
+		// to drop the backlog
+		//******************************
+		inline uint64_t get_resyncs() const noexcept { return resyncs; }
+
+		//******************************
+		// Restart the frame deadlines
+		// from the current time and
+		// cycle, e.g. after a pause
+		//******************************
+		void resync() noexcept;
+	private:
+		// how many frames we may lag before giving up on catching up
+		static const uint32_t max_lag = 4;
+
+		i8080& cpu;
+		uint32_t frequency;
+		uint32_t frame_rate;
+
+		// frame deadlines are computed from these anchors rather
+		// than accumulated, so rounding never builds up into drift
+		clock::time_point start_time;
+		uint64_t start_cycle;
+		uint64_t frame = 0;
+
+		uint64_t frames = 0;
+		uint64_t resyncs = 0;
+		double headroom = 1.0;
+	};
+}
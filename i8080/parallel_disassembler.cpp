@@ -0,0 +1,126 @@
+//**************************************
+// parallel_disassembler.cpp
+//
+// Holds the definition of the parallel
+// linear disassembler, which decodes a
+// large image in chunks on several
+// threads and stitches the listings
+// back together in address order
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "parallel_disassembler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "disassembler.h"
+
+namespace i8080
+{
+	// one chunk's listing, decoded from the start of the chunk
+	// without knowing where the previous chunk's last instruction
+	// ends
+	struct Chunk
+	{
+		// offset of each instruction decoded, and where its line
+		// starts in text
+		std::vector<uint32_t> starts;
+		std::vector<uint32_t> lines;
+		std::vector<char> text;
+		// offset just past the last instruction, which can spill up
+		// to 2 bytes into the next chunk
+		size_t end = 0;
+	};
+
+	//**********************************
+	// Decode one chunk
+	//**********************************
+	static void decode_chunk(const uint8_t* image, size_t size, uint16_t base, size_t first, size_t last, Chunk& chunk)
+	{
+		// instructions average under 2 bytes and lines about 20
+		// characters, so this rarely has to grow
+		chunk.starts.clear();
+		chunk.lines.clear();
+		chunk.starts.reserve((last - first) / 2);
+		chunk.lines.reserve((last - first) / 2);
+		chunk.text.resize((last - first) * 12 + Disassembler::max_line);
+
+		size_t offset = first;
+		size_t written = 0;
+		Instruction instruction;
+		while (offset < last && Disassembler::DecodeInstruction(image + offset, size - offset, static_cast<uint16_t>(base + offset), instruction))
+		{
+			if (chunk.text.size() - written <= Disassembler::max_line) chunk.text.resize(chunk.text.size() * 2);
+			chunk.starts.push_back(static_cast<uint32_t>(offset));
+			chunk.lines.push_back(static_cast<uint32_t>(written));
+			written += Disassembler::FormatInstruction(instruction, chunk.text.data() + written);
+			chunk.text[written++] = '\n';
+			offset += instruction.length;
+		}
+		chunk.text.resize(written);
+		chunk.end = offset;
+	}
+
+	//**********************************
+	// Disassemble in parallel
+	//**********************************
+	void disassemble_parallel(const uint8_t* image, size_t size, uint16_t base, std::ostream& out,
+		unsigned threads, size_t chunk_size)
+	{
+		if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+		chunk_size = std::max<size_t>(chunk_size, 16);
+		size_t count = (size + chunk_size - 1) / chunk_size;
+		std::vector<Chunk> chunks(count);
+
+		// workers claim chunks from a shared counter and only ever
+		// touch their own chunk, so nothing needs a lock
+		std::atomic<size_t> next{ 0 };
+		auto work = [&]()
+		{
+			size_t index;
+			while ((index = next.fetch_add(1, std::memory_order_relaxed)) < count)
+				decode_chunk(image, size, base, index * chunk_size, std::min(size, (index + 1) * chunk_size), chunks[index]);
+		};
+		std::vector<std::thread> workers;
+		for (unsigned i = 1; i < std::min<size_t>(threads, count); ++i) workers.emplace_back(work);
+		work();
+		for (std::thread& worker : workers) worker.join();
+
+		// stitch the chunks together; where the previous chunk really
+		// ended decides where this one starts, and a linear sweep from
+		// there falls back into step with the chunk's own sweep as soon
+		// as both land on the same instruction, which takes only a few
+		// instructions on real code
+		size_t offset = 0;
+		char line[Disassembler::max_line + 1];
+		for (const Chunk& chunk : chunks)
+		{
+			Instruction instruction;
+			auto synced = std::lower_bound(chunk.starts.begin(), chunk.starts.end(), offset);
+			while (offset < size && (synced == chunk.starts.end() || *synced != offset))
+			{
+				// nothing in this chunk lines up, so the next one
+				// carries on from wherever this leaves off
+				if (synced == chunk.starts.end() && offset >= chunk.end) break;
+				if (!Disassembler::DecodeInstruction(image + offset, size - offset, static_cast<uint16_t>(base + offset), instruction))
+					return;
+				size_t length = Disassembler::FormatInstruction(instruction, line);
+				line[length++] = '\n';
+				out.write(line, length);
+				offset += instruction.length;
+				synced = std::lower_bound(synced, chunk.starts.end(), offset);
+			}
+
+			if (synced != chunk.starts.end())
+			{
+				size_t from = chunk.lines[synced - chunk.starts.begin()];
+				out.write(chunk.text.data() + from, chunk.text.size() - from);
+				offset = chunk.end;
+			}
+		}
+	}
+}
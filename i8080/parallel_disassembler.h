@@ -0,0 +1,34 @@
+//**************************************
+// parallel_disassembler.h
+//
+// Holds the declaration of the parallel
+// linear disassembler, which decodes a
+// large image in chunks on several
+// threads and stitches the listings
+// back together in address order
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace i8080
+{
+	//**********************************
+	// Disassemble an image the same way
+	// Disassembler::DisassembleBuffer
+	// would, splitting it into chunks of
+	// chunk_size bytes decoded on up to
+	// threads threads (0 for one per
+	// core)
+	//
+	// Addresses wrap at 64 KiB, so
+	// images bigger than that show
+	// offsets from base modulo 0x10000
+	//**********************************
+	void disassemble_parallel(const uint8_t* image, size_t size, uint16_t base, std::ostream& out,
+		unsigned threads = 0, size_t chunk_size = 1 << 18);
+}
@@ -0,0 +1,113 @@
+//**************************************
+// perf_events.cpp
+//
+// Holds the definition of the host
+// hardware counters (Linux perf_event)
+// that can be attached to the run loop
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "perf_events.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace i8080
+{
+#ifdef __linux__
+	//**********************************
+	// Open one hardware event for the
+	// calling thread
+	//**********************************
+	static int open_event(uint64_t config, int group) noexcept
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = config;
+		attr.read_format = PERF_FORMAT_GROUP;
+		// only the leader starts disabled; the rest follow it
+		attr.disabled = group < 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+	}
+#endif
+
+	//**********************************
+	// Destructor
+	//**********************************
+	PerfEvents::~PerfEvents()
+	{
+#ifdef __linux__
+		if (cache_misses >= 0) close(cache_misses);
+		if (branch_misses >= 0) close(branch_misses);
+		if (leader >= 0) close(leader);
+#endif
+	}
+
+	//**********************************
+	// Open the event group
+	//**********************************
+	void PerfEvents::open() noexcept
+	{
+		tried = true;
+#ifdef __linux__
+		leader = open_event(PERF_COUNT_HW_CPU_CYCLES, -1);
+		if (leader < 0) return;
+		branch_misses = open_event(PERF_COUNT_HW_BRANCH_MISSES, leader);
+		cache_misses = open_event(PERF_COUNT_HW_CACHE_MISSES, leader);
+#endif
+	}
+
+	//**********************************
+	// Start counting
+	//**********************************
+	void PerfEvents::start() noexcept
+	{
+		if (!tried) open();
+#ifdef __linux__
+		if (leader >= 0) ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+	}
+
+	//**********************************
+	// Stop counting
+	//**********************************
+	void PerfEvents::stop() noexcept
+	{
+#ifdef __linux__
+		if (leader >= 0) ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+	}
+
+	//**********************************
+	// Read the totals
+	//**********************************
+	PerfCounts PerfEvents::read() const noexcept
+	{
+		PerfCounts counts;
+#ifdef __linux__
+		if (leader < 0) return counts;
+
+		// a group read gives the number of events, then each value
+		// in the order they were opened
+		uint64_t values[4] = {};
+		if (::read(leader, values, sizeof(values)) < static_cast<ssize_t>(sizeof(uint64_t) * 2)) return counts;
+		counts.host_cycles = values[1];
+		if (branch_misses >= 0 && values[0] > 1) counts.branch_misses = values[2];
+		// without branch misses the cache misses come second, and
+		// the group has to hold at least that many values
+		size_t cache_index = branch_misses >= 0 ? 3 : 2;
+		if (cache_misses >= 0 && values[0] >= cache_index) counts.cache_misses = values[cache_index];
+#endif
+		return counts;
+	}
+}
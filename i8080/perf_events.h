@@ -0,0 +1,72 @@
+//**************************************
+// perf_events.h
+//
+// Holds the declaration of the host
+// hardware counters (Linux perf_event)
+// that can be attached to the run loop
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+
+namespace i8080
+{
+	// host hardware events counted while the run loop ran
+	struct PerfCounts
+	{
+		uint64_t host_cycles = 0;
+		uint64_t branch_misses = 0;
+		uint64_t cache_misses = 0;
+	};
+
+	class PerfEvents final
+	{
+	public:
+		//******************************
+		// Constructor, nothing is opened
+		// until the first start() so the
+		// counters follow whichever
+		// thread runs the CPU
+		//******************************
+		PerfEvents() = default;
+		PerfEvents(const PerfEvents&) = delete;
+		PerfEvents& operator=(const PerfEvents&) = delete;
+
+		//******************************
+		// Destructor, closes the events
+		//******************************
+		~PerfEvents();
+
+		//******************************
+		// Start and stop counting
+		//******************************
+		void start() noexcept;
+		void stop() noexcept;
+
+		//******************************
+		// Get whether the counters could
+		// be opened (they can't off Linux
+		// or when perf_event_paranoid
+		// forbids it)
+		//******************************
+		inline bool is_available() const noexcept { return leader >= 0; }
+
+		//******************************
+		// Get the totals counted so far
+		//******************************
+		PerfCounts read() const noexcept;
+	private:
+		int leader = -1;
+		int branch_misses = -1;
+		int cache_misses = -1;
+		bool tried = false;
+
+		//******************************
+		// Open the event group
+		//******************************
+		void open() noexcept;
+	};
+}
@@ -0,0 +1,79 @@
+//**************************************
+// perf_monitor.cpp
+//
+// Holds the definition of the monitor
+// that samples the CPU's counters and
+// works out how fast it is running over
+// a sliding window
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "perf_monitor.h"
+
+#include <algorithm>
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	PerfMonitor::PerfMonitor(const i8080& cpu, size_t window, const PerfEvents* events)
+		: cpu(cpu), events(events), created(std::chrono::steady_clock::now()),
+		samples(std::max<size_t>(window, 1) + 1)
+	{
+		// the first sample is the starting point for the rates
+		samples[0].instructions = cpu.get_instructions();
+		samples[0].cycles = cpu.get_cycles();
+		samples[0].host_ns = cpu.get_host_time();
+		if (events) samples[0].events = events->read();
+	}
+
+	//**********************************
+	// Record the CPU's counters
+	//**********************************
+	void PerfMonitor::sample() noexcept
+	{
+		newest = (newest + 1) % samples.size();
+		count = std::min(count + 1, samples.size());
+
+		PerfSample& sample = samples[newest];
+		sample.instructions = cpu.get_instructions();
+		sample.cycles = cpu.get_cycles();
+		sample.host_ns = cpu.get_host_time();
+		sample.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - created).count();
+		if (events) sample.events = events->read();
+	}
+
+	//**********************************
+	// Get the rates over the window
+	//**********************************
+	PerfRates PerfMonitor::get_rates() const noexcept
+	{
+		PerfRates rates;
+		if (count < 2) return rates;
+
+		const PerfSample& last = samples[newest];
+		const PerfSample& first = samples[(newest + samples.size() - (count - 1)) % samples.size()];
+		double instructions = static_cast<double>(last.instructions - first.instructions);
+		double cycles = static_cast<double>(last.cycles - first.cycles);
+		double host_ns = static_cast<double>(last.host_ns - first.host_ns);
+		double wall_ns = static_cast<double>(last.wall_ns - first.wall_ns);
+
+		// cycles per nanosecond * 1000 = millions per second
+		if (wall_ns > 0)
+		{
+			rates.mhz = cycles * 1000 / wall_ns;
+			rates.mips = instructions * 1000 / wall_ns;
+		}
+		if (host_ns > 0) rates.run_mhz = cycles * 1000 / host_ns;
+		rates.host_ns_per_sample = host_ns / (count - 1);
+		if (instructions > 0)
+		{
+			rates.host_cycles_per_instruction = (last.events.host_cycles - first.events.host_cycles) / instructions;
+			rates.branch_misses_per_instruction = (last.events.branch_misses - first.events.branch_misses) / instructions;
+			rates.cache_misses_per_instruction = (last.events.cache_misses - first.events.cache_misses) / instructions;
+		}
+		return rates;
+	}
+}
@@ -0,0 +1,92 @@
+//**************************************
+// perf_monitor.h
+//
+// Holds the declaration of the monitor
+// that samples the CPU's counters and
+// works out how fast it is running over
+// a sliding window
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "i8080.h"
+
+namespace i8080
+{
+	// the CPU's cumulative counters at one moment
+	struct PerfSample
+	{
+		uint64_t instructions = 0;
+		uint64_t cycles = 0;
+		// host time spent inside run_until
+		uint64_t host_ns = 0;
+		// host time since the monitor was made
+		uint64_t wall_ns = 0;
+		PerfCounts events;
+	};
+
+	// rates over the sliding window
+	struct PerfRates
+	{
+		// emulated cycles and instructions per wall-clock second, in
+		// millions (what was achieved, pacing included)
+		double mhz = 0;
+		double mips = 0;
+		// emulated cycles per second spent running, in millions (what
+		// could be achieved unpaced)
+		double run_mhz = 0;
+		// host time spent running per sample (per frame when sampled
+		// once a frame)
+		double host_ns_per_sample = 0;
+		// host events per emulated instruction, zero without events
+		double host_cycles_per_instruction = 0;
+		double branch_misses_per_instruction = 0;
+		double cache_misses_per_instruction = 0;
+	};
+
+	class PerfMonitor final
+	{
+	public:
+		//******************************
+		// Constructor, takes the CPU to
+		// watch and how many samples the
+		// sliding window covers
+		//******************************
+		explicit PerfMonitor(const i8080& cpu, size_t window = 60, const PerfEvents* events = nullptr);
+
+		//******************************
+		// Record the CPU's counters,
+		// usually once per frame
+		//
+		// Doesn't allocate
+		//******************************
+		void sample() noexcept;
+
+		//******************************
+		// Get the newest sample
+		//******************************
+		inline const PerfSample& get_totals() const noexcept { return samples[newest]; }
+
+		//******************************
+		// Get the rates between the
+		// oldest and newest samples in
+		// the window
+		//******************************
+		PerfRates get_rates() const noexcept;
+	private:
+		const i8080& cpu;
+		const PerfEvents* events;
+		std::chrono::steady_clock::time_point created;
+
+		// ring of the last window + 1 samples
+		std::vector<PerfSample> samples;
+		size_t newest = 0;
+		size_t count = 1;
+	};
+}
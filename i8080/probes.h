@@ -0,0 +1,39 @@
+//**************************************
+// probes.h
+//
+// Defines the USDT (SystemTap/DTrace
+// style) static probes placed in the
+// CPU, which bpftrace, perf or stap can
+// attach to without a rebuild
+//
+// Each probe compiles to a single NOP
+// plus a note in the binary; define
+// I8080_NO_PROBES to leave them out
+// entirely. Hosts without sys/sdt.h
+// (Windows, or Linux without the
+// systemtap headers) get no probes.
+//
+// Probes (provider i8080):
+//   instruction(pc, opcode)
+//   interrupt(vector, pc)
+//   port_in(port, value)
+//   port_out(port, value)
+//   halt(pc, cycle)
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#if !defined(I8080_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define I8080_PROBES 1
+#endif
+#endif
+
+#ifdef I8080_PROBES
+#define I8080_PROBE2(name, a, b) DTRACE_PROBE2(i8080, name, a, b)
+#else
+#define I8080_PROBE2(name, a, b) ((void)0)
+#endif
@@ -0,0 +1,110 @@
+//**************************************
+// profiler.cpp
+//
+// Holds the definition of the guest
+// call-graph profiler, which follows
+// calls and returns to charge emulated
+// cycles to each guest routine
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "profiler.h"
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	Profiler::Profiler()
+	{
+		reset();
+	}
+
+	//**********************************
+	// Follow a call
+	//**********************************
+	void Profiler::call(uint16_t target, uint16_t sp)
+	{
+		// the stack grows down, so any frame whose return address
+		// sits at or below the new one has been abandoned (SP was
+		// reloaded, or the routine left without returning)
+		while (!stack.empty() && stack.back().sp <= sp) stack.pop_back();
+		if (stack.size() >= max_depth) stack.erase(stack.begin());
+
+		uint32_t parent = stack.empty() ? 0 : stack.back().node;
+		uint64_t key = (static_cast<uint64_t>(parent) << 16) | target;
+		auto found = children.find(key);
+		if (found == children.end())
+		{
+			found = children.emplace(key, static_cast<uint32_t>(nodes.size())).first;
+			nodes.push_back(Node{ target, parent, 0 });
+		}
+
+		stack.push_back(Frame{ found->second, sp });
+		current = found->second;
+	}
+
+	//**********************************
+	// Follow a return
+	//**********************************
+	void Profiler::ret(uint16_t sp) noexcept
+	{
+		// a plain return pops exactly the frame that pushed the
+		// address at sp; if the routine moved SP up itself we pop
+		// everything it skipped over, and if SP is below the top
+		// frame this is a computed jump (PUSH then RET), not a return
+		while (!stack.empty() && stack.back().sp <= sp) stack.pop_back();
+		current = stack.empty() ? 0 : stack.back().node;
+	}
+
+	//**********************************
+	// Drop everything collected
+	//**********************************
+	void Profiler::reset()
+	{
+		nodes.clear();
+		children.clear();
+		stack.clear();
+		// node 0 is whatever runs outside of any call
+		nodes.push_back(Node{ 0, 0, 0 });
+		current = 0;
+	}
+
+	//**********************************
+	// Write the path to a node
+	//**********************************
+	void Profiler::write_path(std::ostream& out, uint32_t node, const SymbolTable* symbols) const
+	{
+		if (node == 0)
+		{
+			out << "root";
+			return;
+		}
+		write_path(out, nodes[node].parent, symbols);
+		std::string_view symbol = symbols ? symbols->find(nodes[node].routine) : std::string_view();
+		if (!symbol.empty()) out << ";" << symbol;
+		else
+		{
+			// formatted here so the caller's stream keeps its own fill
+			// and base
+			static const char digits[] = "0123456789abcdef";
+			uint16_t routine = nodes[node].routine;
+			char text[7] = { ';', '0', 'x', digits[routine >> 12], digits[(routine >> 8) & 0xF], digits[(routine >> 4) & 0xF], digits[routine & 0xF] };
+			out.write(text, sizeof(text));
+		}
+	}
+
+	//**********************************
+	// Write the folded stacks
+	//**********************************
+	void Profiler::write_folded(std::ostream& out, const SymbolTable* symbols) const
+	{
+		for (uint32_t node = 0; node < nodes.size(); ++node)
+		{
+			if (nodes[node].cycles == 0) continue;
+			write_path(out, node, symbols);
+			out << " " << nodes[node].cycles << "\n";
+		}
+	}
+}
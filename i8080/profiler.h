@@ -0,0 +1,107 @@
+//**************************************
+// profiler.h
+//
+// Holds the declaration of the guest
+// call-graph profiler, which follows
+// calls and returns to charge emulated
+// cycles to each guest routine
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "symbol_table.h"
+
+namespace i8080
+{
+	class Profiler final
+	{
+	public:
+		//******************************
+		// Constructor
+		//******************************
+		Profiler();
+
+		//******************************
+		// Charge every cycle since the
+		// last charge to the routine
+		// that is running
+		//******************************
+		inline void charge(uint64_t cycles) noexcept
+		{
+			nodes[current].cycles += cycles - last;
+			last = cycles;
+		}
+
+		//******************************
+		// Start counting from cycles
+		// without charging anything
+		//******************************
+		inline void sync(uint64_t cycles) noexcept { last = cycles; }
+
+		//******************************
+		// A call (or RST or interrupt)
+		// just went to target, leaving
+		// the stack pointer at sp
+		//******************************
+		void call(uint16_t target, uint16_t sp);
+
+		//******************************
+		// A return just ran, with the
+		// stack pointer at sp before it
+		//******************************
+		void ret(uint16_t sp) noexcept;
+
+		//******************************
+		// Drop everything collected
+		//******************************
+		void reset();
+
+		//******************************
+		// Write the cycles charged to
+		// each call stack in the folded
+		// format flamegraph tools read,
+		// one "a;b;c cycles" per line,
+		// naming routines that have a
+		// symbol
+		//******************************
+		void write_folded(std::ostream& out, const SymbolTable* symbols = nullptr) const;
+	private:
+		// a routine reached through a particular call stack
+		struct Node
+		{
+			uint16_t routine;
+			uint32_t parent;
+			uint64_t cycles;
+		};
+
+		// a call that hasn't returned yet
+		struct Frame
+		{
+			uint32_t node;
+			uint16_t sp;
+		};
+
+		// how deep the shadow stack may get before the oldest
+		// frames are assumed to be abandoned
+		static const size_t max_depth = 256;
+
+		std::vector<Node> nodes;
+		// child node for each (parent node, routine) pair
+		std::unordered_map<uint64_t, uint32_t> children;
+		std::vector<Frame> stack;
+		uint32_t current = 0;
+		uint64_t last = 0;
+
+		//******************************
+		// Write the path to a node
+		//******************************
+		void write_path(std::ostream& out, uint32_t node, const SymbolTable* symbols) const;
+	};
+}
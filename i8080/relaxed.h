@@ -0,0 +1,47 @@
+//**************************************
+// relaxed.h
+//
+// Defines relaxed atomic loads and
+// stores on plain bytes, for memory the
+// CPU writes while another thread reads
+// it (std::atomic_ref needs C++20)
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace i8080
+{
+	//**********************************
+	// Read a byte another thread may
+	// be writing
+	//**********************************
+	inline uint8_t load_relaxed(const uint8_t* address) noexcept
+	{
+#ifdef _MSC_VER
+		return static_cast<uint8_t>(__iso_volatile_load8(reinterpret_cast<const volatile char*>(address)));
+#else
+		return __atomic_load_n(address, __ATOMIC_RELAXED);
+#endif
+	}
+
+	//**********************************
+	// Write a byte another thread may
+	// be reading
+	//**********************************
+	inline void store_relaxed(uint8_t* address, uint8_t value) noexcept
+	{
+#ifdef _MSC_VER
+		__iso_volatile_store8(reinterpret_cast<volatile char*>(address), static_cast<char>(value));
+#else
+		__atomic_store_n(address, value, __ATOMIC_RELAXED);
+#endif
+	}
+}
@@ -0,0 +1,159 @@
+//**************************************
+// runner.cpp
+//
+// Holds the definition of the runner
+// that moves the emulation onto its own
+// thread, taking commands in and handing
+// finished frames out without locking
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "runner.h"
+
+#include <chrono>
+
+#include "pacer.h"
+#include "perf_monitor.h"
+
+namespace i8080
+{
+	//**********************************
+	// Constructor
+	//**********************************
+	Runner::Runner(i8080& cpu, uint16_t frame_start, uint16_t frame_size, bool paced,
+		uint32_t frequency, uint32_t frame_rate)
+		: cpu(cpu), frame_start(frame_start), frame_size(frame_size), paced(paced),
+		frequency(frequency), frame_rate(frame_rate)
+	{
+		// every frame copies the region out, so it has to fit
+		if (static_cast<uint32_t>(frame_start) + frame_size > cpu.get_memory_size()) throw -1;
+		// checked here rather than left to the Pacer, which is made on
+		// the emulation thread where nothing could catch it
+		if (frame_rate == 0) throw -1;
+	}
+
+	//**********************************
+	// Start the emulation thread
+	//**********************************
+	void Runner::start()
+	{
+		// a thread that finished on its own (the CPU stopped) is
+		// joined and replaced; one still running is left alone
+		if (thread.joinable())
+		{
+			if (running.load(std::memory_order_acquire)) return;
+			thread.join();
+		}
+		quit.store(false, std::memory_order_relaxed);
+		running.store(true, std::memory_order_release);
+		thread = std::thread(&Runner::loop, this);
+	}
+
+	//**********************************
+	// Stop the emulation thread
+	//**********************************
+	void Runner::stop()
+	{
+		quit.store(true, std::memory_order_relaxed);
+		if (thread.joinable()) thread.join();
+	}
+
+	//**********************************
+	// Copy the newest metrics out
+	//**********************************
+	Metrics Runner::copy_metrics()
+	{
+		// the triple buffer allows one consumer, so readers take
+		// turns; the lock covers picking up and copying out, since
+		// another update could otherwise hand front() back to the
+		// producer mid-copy
+		std::lock_guard<std::mutex> lock(metrics_reader);
+		metrics.update();
+		return metrics.front();
+	}
+
+	//**********************************
+	// The emulation thread's loop
+	//**********************************
+	void Runner::loop()
+	{
+		Pacer pacer(cpu, frequency, frame_rate);
+		PerfMonitor monitor(cpu, frame_rate);
+		std::array<uint32_t, Metrics::frame_window> frame_ns{};
+		bool paused = false;
+		bool alive = true;
+		uint64_t number = 0;
+
+		while (alive && !quit.load(std::memory_order_relaxed))
+		{
+			Command command;
+			while (commands.try_pop(command))
+			{
+				switch (command.type)
+				{
+				case Command::Type::Input:
+					cpu.set_input(command.port, command.value);
+					break;
+				case Command::Type::Interrupt:
+				{
+					// goes through the scheduler so it waits out an EI
+					// the frame ended on, like any device's interrupt
+					uint8_t vector = command.value;
+					cpu.get_scheduler().schedule(cpu.get_cycles(), [this, vector](uint64_t) { cpu.interrupt(vector); });
+					break;
+				}
+				case Command::Type::Pause:
+					paused = true;
+					break;
+				case Command::Type::Resume:
+					// don't try to make up for the time spent paused
+					if (paused) pacer.resync();
+					paused = false;
+					break;
+				}
+			}
+
+			if (paused)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			uint64_t host_time = cpu.get_host_time();
+			if (paced) alive = pacer.run_frame();
+			else alive = cpu.run_until(cpu.get_cycles() + frequency / frame_rate);
+			monitor.sample();
+
+			// fill in the back buffer and hand it over; the buffers
+			// keep their capacity so this stops allocating after the
+			// first few frames
+			Frame& frame = frames.back();
+			frame.number = ++number;
+			frame.cycle = cpu.get_cycles();
+			const uint8_t* memory = cpu.get_memory() + frame_start;
+			frame.data.assign(memory, memory + frame_size);
+			frames.publish();
+
+			// the metrics go out the same way, so whoever exports them
+			// never holds up this thread
+			// frame numbers start at 1, and the window fills from slot 0
+			frame_ns[(number - 1) % Metrics::frame_window] = static_cast<uint32_t>(cpu.get_host_time() - host_time);
+			PerfRates rates = monitor.get_rates();
+			Metrics& out = metrics.back();
+			out.instructions = cpu.get_instructions();
+			out.cycles = cpu.get_cycles();
+			out.interrupts = cpu.get_interrupts();
+			out.frames = number;
+			out.host_ns = cpu.get_host_time();
+			out.frame_ns = frame_ns;
+			out.frame_bytes = frame_size;
+			out.mhz = rates.mhz;
+			out.mips = rates.mips;
+			out.run_mhz = rates.run_mhz;
+			metrics.publish();
+		}
+
+		running.store(false, std::memory_order_release);
+	}
+}
@@ -0,0 +1,154 @@
+//**************************************
+// runner.h
+//
+// Holds the declaration of the runner
+// that moves the emulation onto its own
+// thread, taking commands in and handing
+// finished frames out without locking
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "i8080.h"
+#include "metrics.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+namespace i8080
+{
+	// a command sent to the emulation thread
+	struct Command
+	{
+		enum class Type : uint8_t
+		{
+			// latch value on input port
+			Input,
+			// request interrupt RST value
+			Interrupt,
+			Pause,
+			Resume
+		};
+
+		Type type;
+		uint8_t port;
+		uint8_t value;
+	};
+
+	// a snapshot of video memory taken at the end of a frame
+	struct Frame
+	{
+		uint64_t number = 0;
+		uint64_t cycle = 0;
+		std::vector<uint8_t> data;
+	};
+
+	class Runner final
+	{
+	public:
+		//******************************
+		// Constructor, takes the CPU to
+		// run and the region of memory
+		// that is copied out as a frame
+		//
+		// The CPU must not be touched
+		// by anything else while the
+		// runner is started
+		//
+		// Throws -1 when the frame runs
+		// past the end of memory, or the
+		// frame rate is 0
+		//******************************
+		Runner(i8080& cpu, uint16_t frame_start, uint16_t frame_size, bool paced = true,
+			uint32_t frequency = 2000000, uint32_t frame_rate = 60);
+
+		//******************************
+		// Destructor, stops the thread
+		//******************************
+		inline ~Runner() { stop(); }
+
+		//******************************
+		// Start the emulation thread,
+		// or start it again after it
+		// stopped on its own
+		//******************************
+		void start();
+
+		//******************************
+		// Stop the emulation thread and
+		// wait for it to finish
+		//******************************
+		void stop();
+
+		//******************************
+		// Send a command to the
+		// emulation thread
+		//
+		// Returns false without waiting
+		// when the queue is full
+		//******************************
+		inline bool send(const Command& command) noexcept { return commands.try_push(command); }
+
+		//******************************
+		// Pick up the newest finished
+		// frame, if there is one
+		//
+		// Returns false when no new
+		// frame is ready
+		//******************************
+		inline bool update_frame() noexcept { return frames.update(); }
+
+		//******************************
+		// Get the frame picked up by
+		// the last update_frame()
+		//******************************
+		inline const Frame& get_frame() const noexcept { return frames.front(); }
+
+		//******************************
+		// Get a copy of the newest
+		// metrics
+		//
+		// Safe from any number of
+		// threads: they take turns
+		// being the triple buffer's one
+		// consumer, and the emulation
+		// thread never waits for them
+		//******************************
+		Metrics copy_metrics();
+
+		//******************************
+		// Get whether the emulation
+		// thread is still running
+		//******************************
+		inline bool is_running() const noexcept { return running.load(std::memory_order_acquire); }
+	private:
+		i8080& cpu;
+		uint16_t frame_start;
+		uint16_t frame_size;
+		bool paced;
+		uint32_t frequency;
+		uint32_t frame_rate;
+
+		SpscQueue<Command, 256> commands;
+		TripleBuffer<Frame> frames;
+		TripleBuffer<Metrics> metrics;
+		// held by whichever exporter is reading metrics
+		std::mutex metrics_reader;
+
+		std::thread thread;
+		std::atomic<bool> running{ false };
+		std::atomic<bool> quit{ false };
+
+		//******************************
+		// The emulation thread's loop
+		//******************************
+		void loop();
+	};
+}
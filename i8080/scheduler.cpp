@@ -0,0 +1,45 @@
+//**************************************
+// scheduler.cpp
+//
+// Holds the definition of the event
+// scheduler that devices use to run
+// callbacks at a given CPU cycle
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "scheduler.h"
+
+namespace i8080
+{
+	//**********************************
+	// Schedule a callback
+	//**********************************
+	void Scheduler::schedule(uint64_t cycle, callback cb)
+	{
+		events.push(event{ cycle, sequence++, std::move(cb) });
+	}
+
+	//**********************************
+	// Run every due event
+	//**********************************
+	void Scheduler::dispatch(uint64_t now)
+	{
+		while (!events.empty() && events.top().cycle <= now)
+		{
+			// pop before running so the callback is free to
+			// schedule more events, including itself again
+			event e = events.top();
+			events.pop();
+			e.cb(e.cycle);
+		}
+	}
+
+	//**********************************
+	// Drop every pending event
+	//**********************************
+	void Scheduler::clear() noexcept
+	{
+		while (!events.empty()) events.pop();
+	}
+}
@@ -0,0 +1,72 @@
+//**************************************
+// scheduler.h
+//
+// Holds the declaration of the event
+// scheduler that devices use to run
+// callbacks at a given CPU cycle
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace i8080
+{
+	class Scheduler final
+	{
+	public:
+		// an event callback, passed the cycle it was due at
+		using callback = std::function<void(uint64_t)>;
+
+		//******************************
+		// Schedule a callback to run
+		// once the CPU reaches the
+		// given absolute cycle
+		//******************************
+		void schedule(uint64_t cycle, callback cb);
+
+		//******************************
+		// Get the cycle the next event
+		// is due at, or UINT64_MAX if
+		// nothing is scheduled
+		//******************************
+		inline uint64_t next() const noexcept { return events.empty() ? UINT64_MAX : events.top().cycle; }
+
+		//******************************
+		// Run every event that is due
+		// at or before the given cycle
+		//******************************
+		void dispatch(uint64_t now);
+
+		//******************************
+		// Drop every pending event
+		//******************************
+		void clear() noexcept;
+	private:
+		struct event
+		{
+			uint64_t cycle;
+			// breaks ties so events due on the same
+			// cycle run in the order they were added
+			uint64_t sequence;
+			callback cb;
+		};
+
+		// orders the queue so the earliest event is on top
+		struct later
+		{
+			inline bool operator()(const event& a, const event& b) const noexcept
+			{
+				return a.cycle != b.cycle ? a.cycle > b.cycle : a.sequence > b.sequence;
+			}
+		};
+
+		std::priority_queue<event, std::vector<event>, later> events;
+		uint64_t sequence = 0;
+	};
+}
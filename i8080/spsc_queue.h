@@ -0,0 +1,77 @@
+//**************************************
+// spsc_queue.h
+//
+// Holds a fixed size lock-free queue
+// for passing values from exactly one
+// producer thread to one consumer
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace i8080
+{
+	template<typename T, size_t N>
+	class SpscQueue final
+	{
+		static_assert(N && !(N & (N - 1)), "SpscQueue size must be a power of two");
+	public:
+		//******************************
+		// Add a value to the queue
+		//
+		// Returns false without waiting
+		// when the queue is full
+		//******************************
+		bool try_push(const T& value) noexcept
+		{
+			size_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == N) return false;
+			slots[t & (N - 1)] = value;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		//******************************
+		// Take the oldest value out of
+		// the queue
+		//
+		// Returns false without waiting
+		// when the queue is empty
+		//******************************
+		bool try_pop(T& value) noexcept
+		{
+			size_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire)) return false;
+			value = slots[h & (N - 1)];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		//******************************
+		// Take up to count of the oldest
+		// values out of the queue at once
+		//
+		// Returns how many were taken
+		//******************************
+		size_t try_pop(T* values, size_t count) noexcept
+		{
+			size_t h = head.load(std::memory_order_relaxed);
+			size_t available = tail.load(std::memory_order_acquire) - h;
+			if (count > available) count = available;
+			for (size_t i = 0; i < count; ++i) values[i] = slots[(h + i) & (N - 1)];
+			head.store(h + count, std::memory_order_release);
+			return count;
+		}
+	private:
+		// each index lives on its own cache line so the
+		// two threads don't keep stealing it from each other
+		alignas(64) std::atomic<size_t> head{ 0 };
+		alignas(64) std::atomic<size_t> tail{ 0 };
+		std::array<T, N> slots{};
+	};
+}
@@ -0,0 +1,43 @@
+//**************************************
+// state_hash.h
+//
+// Holds a quick (not cryptographic) hash
+// used to compare machine states without
+// comparing every byte of them
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace i8080
+{
+	//**********************************
+	// Hash a block of bytes, chaining
+	// on from seed
+	//**********************************
+	inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) noexcept
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed ^ (size * 0x9E3779B97F4A7C15ull);
+
+		// mix in a word at a time, then whatever bytes are left over
+		for (; size >= 8; size -= 8, bytes += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes, 8);
+			hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 32;
+		}
+		for (; size > 0; --size, ++bytes)
+		{
+			hash = (hash ^ *bytes) * 0xC4CEB9FE1A85EC53ull;
+			hash ^= hash >> 29;
+		}
+		return hash;
+	}
+}
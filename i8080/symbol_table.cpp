@@ -0,0 +1,198 @@
+//**************************************
+// symbol_table.cpp
+//
+// Holds the definition of the symbol
+// table, which maps guest addresses to
+// label names for listings, traces and
+// profiles
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "symbol_table.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace i8080
+{
+	//**********************************
+	// Parse a hex address, allowing a
+	// 0x prefix or H suffix
+	//**********************************
+	static bool parse_address(std::string_view text, uint16_t& address) noexcept
+	{
+		if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) text.remove_prefix(2);
+		else if (text.size() > 1 && (text.back() == 'h' || text.back() == 'H')) text.remove_suffix(1);
+		if (text.empty() || text.size() > 4) return false;
+
+		uint16_t value = 0;
+		for (char c : text)
+		{
+			value <<= 4;
+			if (c >= '0' && c <= '9') value |= c - '0';
+			else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+			else return false;
+		}
+		address = value;
+		return true;
+	}
+
+	//**********************************
+	// Check for a 0x prefix or H suffix
+	//**********************************
+	static bool marked(std::string_view text) noexcept
+	{
+		return (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+			|| (text.size() > 1 && (text.back() == 'h' || text.back() == 'H'));
+	}
+
+	//**********************************
+	// Constructor
+	//**********************************
+	SymbolTable::SymbolTable(const std::string& filename)
+	{
+		load(filename);
+	}
+
+	//**********************************
+	// Load a symbol file
+	//**********************************
+	void SymbolTable::load(const std::string& filename)
+	{
+		std::ifstream file(filename);
+		if (!file.is_open()) throw -1;
+
+		std::string line;
+		std::vector<std::string_view> tokens;
+		while (std::getline(file, line))
+		{
+			// drop comments, then split on whitespace
+			line = line.substr(0, line.find(';'));
+			tokens.clear();
+			size_t at = 0;
+			while ((at = line.find_first_not_of(" \t\r", at)) != std::string::npos)
+			{
+				size_t end = line.find_first_of(" \t\r", at);
+				if (end == std::string::npos) end = line.size();
+				tokens.push_back(std::string_view(line).substr(at, end - at));
+				at = end;
+			}
+
+			// each pair is "name addr" or "addr name"; when both could
+			// be hex (a label like ADD or CAFE) it's read as "name addr"
+			// unless a 0x or H marks only the first as the address
+			for (size_t i = 0; i + 1 < tokens.size(); i += 2)
+			{
+				uint16_t first, second;
+				bool first_address = parse_address(tokens[i], first);
+				bool second_address = parse_address(tokens[i + 1], second);
+				if (second_address && !(first_address && marked(tokens[i]) && !marked(tokens[i + 1]))) insert(tokens[i], second);
+				else if (first_address) insert(tokens[i + 1], first);
+			}
+		}
+		index();
+	}
+
+	//**********************************
+	// Add a symbol
+	//**********************************
+	void SymbolTable::add(std::string_view name, uint16_t address)
+	{
+		insert(name, address);
+		index();
+	}
+
+	//**********************************
+	// Add a symbol without reindexing
+	//**********************************
+	void SymbolTable::insert(std::string_view name, uint16_t address)
+	{
+		if (!symbols.empty() && address < symbols.back().address) sorted = false;
+		symbols.push_back(Symbol{ address, static_cast<uint16_t>(name.size()), static_cast<uint32_t>(names.size()) });
+		names.append(name);
+	}
+
+	//**********************************
+	// Sort and rebuild the page index
+	//**********************************
+	void SymbolTable::index()
+	{
+		if (!sorted)
+		{
+			std::stable_sort(symbols.begin(), symbols.end(),
+				[](const Symbol& a, const Symbol& b) { return a.address < b.address; });
+			sorted = true;
+		}
+
+		size_t at = 0;
+		for (uint32_t page = 0; page < 256; ++page)
+		{
+			while (at < symbols.size() && symbols[at].address < (page << 8)) ++at;
+			pages[page] = static_cast<uint32_t>(at);
+		}
+		pages[256] = static_cast<uint32_t>(symbols.size());
+	}
+
+	//**********************************
+	// Find the last symbol at or below
+	//**********************************
+	size_t SymbolTable::below(uint16_t address) const noexcept
+	{
+		uint32_t first = pages[address >> 8];
+		uint32_t last = pages[(address >> 8) + 1];
+		// only this page needs searching; if nothing in it is low
+		// enough, the last symbol before the page is the one
+		size_t found = std::upper_bound(symbols.begin() + first, symbols.begin() + last, address,
+			[](uint16_t address, const Symbol& symbol) { return address < symbol.address; }) - symbols.begin();
+		return found == 0 ? symbols.size() : found - 1;
+	}
+
+	//**********************************
+	// Find the symbol at an address
+	//**********************************
+	std::string_view SymbolTable::find(uint16_t address) const noexcept
+	{
+		size_t at = below(address);
+		if (at == symbols.size() || symbols[at].address != address) return std::string_view();
+		return name(symbols[at]);
+	}
+
+	//**********************************
+	// Find the closest symbol below
+	//**********************************
+	std::string_view SymbolTable::nearest(uint16_t address, uint16_t& offset) const noexcept
+	{
+		size_t at = below(address);
+		if (at == symbols.size()) return std::string_view();
+		offset = address - symbols[at].address;
+		return name(symbols[at]);
+	}
+
+	//**********************************
+	// Describe an address
+	//**********************************
+	size_t SymbolTable::describe(uint16_t address, char* buffer) const noexcept
+	{
+		static const char digits[] = "0123456789abcdef";
+		uint16_t offset = 0;
+		std::string_view symbol = nearest(address, offset);
+		if (symbol.empty()) return 0;
+
+		char* out = std::copy_n(symbol.begin(), std::min(symbol.size(), max_name), buffer);
+		if (offset)
+		{
+			out = std::copy_n("+0x", 3, out);
+			bool started = false;
+			for (int shift = 12; shift >= 0; shift -= 4)
+			{
+				uint8_t digit = (offset >> shift) & 0xF;
+				if (!digit && !started && shift) continue;
+				started = true;
+				*out++ = digits[digit];
+			}
+		}
+		return out - buffer;
+	}
+}
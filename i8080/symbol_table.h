@@ -0,0 +1,142 @@
+//**************************************
+// symbol_table.h
+//
+// Holds the declaration of the symbol
+// table, which maps guest addresses to
+// label names for listings, traces and
+// profiles
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace i8080
+{
+	class SymbolTable final
+	{
+	public:
+		//******************************
+		// Constructor, makes an empty
+		// table
+		//******************************
+		SymbolTable() = default;
+
+		//******************************
+		// Constructor, loads a symbol
+		// file (see load())
+		//
+		// Throws -1 when the file could
+		// not be opened
+		//******************************
+		explicit SymbolTable(const std::string& filename);
+
+		//******************************
+		// Load a symbol file, either
+		// "name addr" lines or assembler
+		// .sym output ("addr name" pairs,
+		// several to a line); addresses
+		// are hex, with or without 0x or
+		// a trailing H
+		//
+		// When both of a pair could be
+		// hex it's taken as "name addr",
+		// unless only the first has 0x
+		// or H
+		//
+		// Throws -1 when the file could
+		// not be opened
+		//******************************
+		void load(const std::string& filename);
+
+		//******************************
+		// Add a symbol
+		//******************************
+		void add(std::string_view name, uint16_t address);
+
+		//******************************
+		// Get the number of symbols
+		//******************************
+		inline size_t size() const noexcept { return symbols.size(); }
+
+		//******************************
+		// Get the name of the symbol at
+		// exactly an address, or an
+		// empty view when there isn't one
+		//******************************
+		std::string_view find(uint16_t address) const noexcept;
+
+		//******************************
+		// Get the closest symbol at or
+		// below an address, setting
+		// offset to how far past it the
+		// address is
+		//
+		// Returns an empty view when
+		// nothing is below the address
+		//******************************
+		std::string_view nearest(uint16_t address, uint16_t& offset) const noexcept;
+
+		//******************************
+		// Write "name" or "name+0xoff"
+		// for an address into buffer,
+		// cutting the name at max_name
+		// characters
+		//
+		// Returns the characters written,
+		// or 0 when nothing is below the
+		// address
+		//******************************
+		size_t describe(uint16_t address, char* buffer) const noexcept;
+
+		// the longest name describe() writes
+		static constexpr size_t max_name = 32;
+		// the longest text describe() writes
+		static constexpr size_t max_describe = max_name + 7;
+	private:
+		struct Symbol
+		{
+			uint16_t address;
+			uint16_t length;
+			uint32_t name;
+		};
+
+		// sorted by address, names packed into one string
+		std::vector<Symbol> symbols;
+		std::string names;
+		// first symbol at or after the start of each page, so a
+		// lookup only ever searches one page's worth
+		std::array<uint32_t, 257> pages{};
+		bool sorted = true;
+
+		//******************************
+		// Add a symbol, leaving the
+		// index to be rebuilt after
+		//******************************
+		void insert(std::string_view name, uint16_t address);
+
+		//******************************
+		// Sort and rebuild the page
+		// index after symbols were added
+		//******************************
+		void index();
+
+		//******************************
+		// Get the index of the last
+		// symbol at or below an address,
+		// or size() when there is none
+		//******************************
+		size_t below(uint16_t address) const noexcept;
+
+		//******************************
+		// Get a symbol's name
+		//******************************
+		inline std::string_view name(const Symbol& symbol) const noexcept { return std::string_view(names).substr(symbol.name, symbol.length); }
+	};
+}
@@ -0,0 +1,29 @@
+//**************************************
+// trace.cpp
+//
+// Holds the definition of the trace
+// sinks that instructions are reported
+// to while tracing is turned on
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "trace.h"
+
+#include "i8080.h"
+
+namespace i8080
+{
+	//**********************************
+	// Print the PC of an instruction
+	//**********************************
+	void TextTraceSink::trace(const i8080& cpu) noexcept
+	{
+		// formatted here rather than with the stream's manipulators,
+		// which would stay set on the caller's stream
+		static const char digits[] = "0123456789abcdef";
+		uint16_t pc = cpu.get_state().PC;
+		char line[7] = { '0', 'x', digits[pc >> 12], digits[(pc >> 8) & 0xF], digits[(pc >> 4) & 0xF], digits[pc & 0xF], '\n' };
+		out.write(line, sizeof(line));
+	}
+}
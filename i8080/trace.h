@@ -0,0 +1,48 @@
+//**************************************
+// trace.h
+//
+// Holds the declaration of the trace
+// sinks that instructions are reported
+// to while tracing is turned on
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <iostream>
+
+namespace i8080
+{
+	class i8080;
+
+	class TraceSink
+	{
+	public:
+		virtual ~TraceSink() = default;
+
+		//******************************
+		// Called before each traced
+		// instruction runs, while PC
+		// still points at its opcode
+		//******************************
+		virtual void trace(const i8080& cpu) noexcept = 0;
+	};
+
+	class TextTraceSink final : public TraceSink
+	{
+	public:
+		//******************************
+		// Constructor, takes the stream
+		// to print each PC to
+		//******************************
+		inline TextTraceSink(std::ostream& out = std::cout) noexcept : out(out) {}
+
+		//******************************
+		// Print the PC of an instruction
+		//******************************
+		void trace(const i8080& cpu) noexcept override;
+	private:
+		std::ostream& out;
+	};
+}
@@ -0,0 +1,68 @@
+//**************************************
+// trace_format.h
+//
+// Holds the layout of binary execution
+// traces, which are a file of fixed size
+// instruction records plus a side file
+// of full state keyframes
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <cstdint>
+
+namespace i8080
+{
+	namespace trace
+	{
+		// bump whenever the layout of anything below changes
+		const uint32_t version = 2;
+
+		// the magic numbers at the start of each file
+		const char record_magic[8] = { 'I', '8', '0', '8', '0', 'T', 'R', 0 };
+		const char keyframe_magic[8] = { 'I', '8', '0', '8', '0', 'K', 'F', 0 };
+
+		// keyframes go in a file next to the trace with this suffix
+		const char keyframe_suffix[] = ".keys";
+
+		// starts both files, followed by fixed size entries
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t entry_size;
+		};
+
+		// one instruction along with the state it started in
+		struct Record
+		{
+			uint64_t cycle;
+			uint16_t pc;
+			uint16_t sp;
+			uint8_t op;
+			uint8_t operands[2];
+			uint8_t A, F, B, C, D, E, H, L;
+			uint8_t flags;
+		};
+
+		// bits set in Record::flags
+		const uint8_t inte = 1 << 0;
+
+		// the full machine state as of the start of record index
+		struct Keyframe
+		{
+			uint64_t index;
+			Record state;
+			// hash_bytes() of memory chained on from state,
+			// so two traces can be compared keyframe by keyframe
+			uint64_t hash;
+			uint8_t memory[0x10000];
+		};
+
+		static_assert(sizeof(Header) == 16, "trace header layout changed");
+		static_assert(sizeof(Record) == 24, "trace record layout changed");
+		static_assert(sizeof(Keyframe) == 40 + 0x10000, "trace keyframe layout changed");
+	}
+}
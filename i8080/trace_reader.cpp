@@ -0,0 +1,111 @@
+//**************************************
+// trace_reader.cpp
+//
+// Holds the definition of the reader
+// for binary trace files, which maps
+// them into memory so records can be
+// searched and decoded in place
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "trace_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "disassembler.h"
+
+namespace i8080
+{
+	//**********************************
+	// Check a file header, returning
+	// how many entries follow it
+	//**********************************
+	static size_t check_header(const MappedFile& file, const char (&magic)[8], uint32_t entry_size)
+	{
+		if (file.size() < sizeof(trace::Header)) throw -1;
+		trace::Header header;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0) throw -1;
+		if (header.version != trace::version || header.entry_size != entry_size) throw -1;
+		// a trace that was cut off keeps every whole entry
+		return (file.size() - sizeof(header)) / entry_size;
+	}
+
+	//**********************************
+	// Constructor
+	//**********************************
+	TraceReader::TraceReader(const std::string& filename)
+		: record_file(filename)
+	{
+		count = check_header(record_file, trace::record_magic, sizeof(trace::Record));
+		records = reinterpret_cast<const trace::Record*>(record_file.data() + sizeof(trace::Header));
+
+		// keyframes are optional, the records alone are still useful
+		try
+		{
+			keyframe_file.reset(new MappedFile(filename + trace::keyframe_suffix));
+			keyframes_count = check_header(*keyframe_file, trace::keyframe_magic, sizeof(trace::Keyframe));
+			keyframes = reinterpret_cast<const trace::Keyframe*>(keyframe_file->data() + sizeof(trace::Header));
+		}
+		catch (int)
+		{
+			keyframe_file.reset();
+			keyframes_count = 0;
+		}
+	}
+
+	//**********************************
+	// Find the keyframe before a record
+	//**********************************
+	size_t TraceReader::keyframe_before(size_t index) const noexcept
+	{
+		// keyframes are in record order, so find the first one past
+		// the record and step back one
+		const trace::Keyframe* end = keyframes + keyframes_count;
+		const trace::Keyframe* after = std::upper_bound(keyframes, end, index,
+			[](size_t i, const trace::Keyframe& k) { return i < k.index; });
+		return after == keyframes ? keyframes_count : (after - keyframes) - 1;
+	}
+
+	//**********************************
+	// Find the record at a cycle
+	//**********************************
+	size_t TraceReader::seek_cycle(uint64_t cycle) const noexcept
+	{
+		const trace::Record* found = std::lower_bound(records, records + count, cycle,
+			[](const trace::Record& r, uint64_t c) { return r.cycle < c; });
+		return found - records;
+	}
+
+	//**********************************
+	// Find the next record in a range
+	//**********************************
+	size_t TraceReader::find_pc(size_t index, uint16_t first, uint16_t last) const noexcept
+	{
+		for (; index < count; ++index)
+			if (records[index].pc >= first && records[index].pc <= last) break;
+		return index;
+	}
+
+	//**********************************
+	// Format a record
+	//**********************************
+	std::string TraceReader::Decode(const trace::Record& record, const SymbolTable* symbols)
+	{
+		uint8_t bytes[3] = { record.op, record.operands[0], record.operands[1] };
+		std::stringstream line;
+		line << std::setfill(' ') << std::setw(26) << std::left << Disassembler::Decode(record.pc, bytes, symbols);
+		line << std::right << std::hex << std::setfill('0')
+			<< "A=" << std::setw(2) << +record.A << " F=" << std::setw(2) << +record.F
+			<< " B=" << std::setw(2) << +record.B << " C=" << std::setw(2) << +record.C
+			<< " D=" << std::setw(2) << +record.D << " E=" << std::setw(2) << +record.E
+			<< " H=" << std::setw(2) << +record.H << " L=" << std::setw(2) << +record.L
+			<< " SP=" << std::setw(4) << record.sp
+			<< std::dec << " CYC=" << record.cycle;
+		return line.str();
+	}
+}
@@ -0,0 +1,102 @@
+//**************************************
+// trace_reader.h
+//
+// Holds the declaration of the reader
+// for binary trace files, which maps
+// them into memory so records can be
+// searched and decoded in place
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "mapped_file.h"
+#include "symbol_table.h"
+#include "trace_format.h"
+
+namespace i8080
+{
+	class TraceReader final
+	{
+	public:
+		//******************************
+		// Constructor, maps the trace
+		// and its keyframes if present
+		//
+		// Throws -1 when the trace can't
+		// be opened or isn't valid
+		//******************************
+		TraceReader(const std::string& filename);
+
+		//******************************
+		// Get the number of records
+		//******************************
+		inline size_t size() const noexcept { return count; }
+
+		//******************************
+		// Get a record by index
+		//******************************
+		inline const trace::Record& operator[](size_t index) const noexcept { return records[index]; }
+
+		//******************************
+		// Get all of the records
+		//******************************
+		inline const trace::Record* data() const noexcept { return records; }
+
+		//******************************
+		// Get the number of keyframes
+		//******************************
+		inline size_t keyframe_count() const noexcept { return keyframes_count; }
+
+		//******************************
+		// Get a keyframe by index
+		//******************************
+		inline const trace::Keyframe& keyframe(size_t index) const noexcept { return keyframes[index]; }
+
+		//******************************
+		// Get the last keyframe taken
+		// at or before a record
+		//
+		// Returns keyframe_count() when
+		// there is no such keyframe
+		//******************************
+		size_t keyframe_before(size_t index) const noexcept;
+
+		//******************************
+		// Get the first record that
+		// starts at or after a cycle
+		//
+		// Returns size() when there is
+		// no such record
+		//******************************
+		size_t seek_cycle(uint64_t cycle) const noexcept;
+
+		//******************************
+		// Get the first record from
+		// index on whose PC is between
+		// first and last
+		//
+		// Returns size() when there is
+		// no such record
+		//******************************
+		size_t find_pc(size_t index, uint16_t first, uint16_t last) const noexcept;
+
+		//******************************
+		// Format a record as a line of
+		// disassembly with its registers
+		//******************************
+		static std::string Decode(const trace::Record& record, const SymbolTable* symbols = nullptr);
+	private:
+		MappedFile record_file;
+		std::unique_ptr<MappedFile> keyframe_file;
+
+		const trace::Record* records = nullptr;
+		size_t count = 0;
+		const trace::Keyframe* keyframes = nullptr;
+		size_t keyframes_count = 0;
+	};
+}
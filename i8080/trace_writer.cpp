@@ -0,0 +1,163 @@
+//**************************************
+// trace_writer.cpp
+//
+// Holds the definition of the trace
+// sink that records every instruction
+// into a binary trace file
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#include "trace_writer.h"
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "i8080.h"
+#include "state_hash.h"
+
+namespace i8080
+{
+	//**********************************
+	// Write a file header
+	//**********************************
+	static void write_header(std::ofstream& file, const char (&magic)[8], uint32_t entry_size)
+	{
+		trace::Header header{};
+		std::memcpy(header.magic, magic, sizeof(header.magic));
+		header.version = trace::version;
+		header.entry_size = entry_size;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+
+	//**********************************
+	// Constructor
+	//**********************************
+	BinaryTraceSink::BinaryTraceSink(const std::string& filename, uint64_t keyframe_interval)
+		: keyframe_interval(keyframe_interval ? keyframe_interval : 1),
+		ring(new SpscQueue<trace::Record, ring_size>()),
+		keyframes(new trace::Keyframe[keyframe_slots]),
+		record_file(filename, std::ios_base::binary | std::ios_base::trunc),
+		keyframe_file(filename + trace::keyframe_suffix, std::ios_base::binary | std::ios_base::trunc)
+	{
+		if (!record_file.is_open() || !keyframe_file.is_open()) throw -1;
+
+		write_header(record_file, trace::record_magic, sizeof(trace::Record));
+		write_header(keyframe_file, trace::keyframe_magic, sizeof(trace::Keyframe));
+
+		for (uint8_t slot = 0; slot < keyframe_slots; ++slot) empty.try_push(slot);
+		writer = std::thread(&BinaryTraceSink::write_loop, this);
+	}
+
+	//**********************************
+	// Capture an instruction's record
+	//**********************************
+	trace::Record trace::capture(const i8080& cpu) noexcept
+	{
+		State state = cpu.get_state();
+		const uint8_t* memory = cpu.get_memory();
+		uint32_t size = cpu.get_memory_size();
+
+		Record record{};
+		record.cycle = state.cycles;
+		record.pc = state.PC;
+		record.sp = state.SP;
+		record.op = state.PC < size ? memory[state.PC] : 0;
+		record.operands[0] = state.PC + 1u < size ? memory[state.PC + 1u] : 0;
+		record.operands[1] = state.PC + 2u < size ? memory[state.PC + 2u] : 0;
+		record.A = state.A;
+		record.F = state.F;
+		record.B = state.B;
+		record.C = state.C;
+		record.D = state.D;
+		record.E = state.E;
+		record.H = state.H;
+		record.L = state.L;
+		record.flags = state.inte ? inte : 0;
+		return record;
+	}
+
+	//**********************************
+	// Record an instruction
+	//**********************************
+	void BinaryTraceSink::trace(const i8080& cpu) noexcept
+	{
+		// nothing drains the ring once the writer is gone, so a CPU
+		// still pointing here after close() is ignored rather than
+		// left waiting forever
+		if (closing.load(std::memory_order_relaxed)) return;
+
+		const uint8_t* memory = cpu.get_memory();
+		uint32_t size = cpu.get_memory_size();
+		trace::Record record = trace::capture(cpu);
+
+		if (records % keyframe_interval == 0)
+		{
+			uint8_t slot;
+			while (!empty.try_pop(slot)) std::this_thread::yield();
+
+			trace::Keyframe& keyframe = keyframes[slot];
+			keyframe.index = records;
+			keyframe.state = record;
+			uint32_t copied = size < sizeof(keyframe.memory) ? size : sizeof(keyframe.memory);
+			std::memcpy(keyframe.memory, memory, copied);
+			std::memset(keyframe.memory + copied, 0, sizeof(keyframe.memory) - copied);
+			filled.try_push(slot);
+		}
+
+		while (!ring->try_push(record))
+		{
+			++stalls;
+			std::this_thread::yield();
+		}
+		++records;
+	}
+
+	//**********************************
+	// Flush and close the files
+	//**********************************
+	void BinaryTraceSink::close() noexcept
+	{
+		closing.store(true, std::memory_order_release);
+		if (writer.joinable()) writer.join();
+		record_file.close();
+		keyframe_file.close();
+	}
+
+	//**********************************
+	// The background writer's loop
+	//**********************************
+	void BinaryTraceSink::write_loop()
+	{
+		std::vector<trace::Record> batch(4096);
+
+		for (;;)
+		{
+			// check before draining, so anything pushed
+			// before we were closed is sure to be seen
+			bool done = closing.load(std::memory_order_acquire);
+
+			size_t count = ring->try_pop(batch.data(), batch.size());
+			if (count) record_file.write(reinterpret_cast<const char*>(batch.data()), count * sizeof(trace::Record));
+
+			uint8_t slot;
+			while (filled.try_pop(slot))
+			{
+				trace::Keyframe& keyframe = keyframes[slot];
+				keyframe.hash = hash_bytes(keyframe.memory, sizeof(keyframe.memory), hash_bytes(&keyframe.state, sizeof(keyframe.state)));
+				keyframe_file.write(reinterpret_cast<const char*>(&keyframes[slot]), sizeof(trace::Keyframe));
+				empty.try_push(slot);
+			}
+
+			if (count == 0)
+			{
+				if (done) break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		record_file.flush();
+		keyframe_file.flush();
+	}
+}
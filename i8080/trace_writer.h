@@ -0,0 +1,108 @@
+//**************************************
+// trace_writer.h
+//
+// Holds the declaration of the trace
+// sink that records every instruction
+// into a binary trace file
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "spsc_queue.h"
+#include "trace.h"
+#include "trace_format.h"
+
+namespace i8080
+{
+	namespace trace
+	{
+		//******************************
+		// Capture the record for the
+		// instruction the CPU is about
+		// to run
+		//******************************
+		Record capture(const i8080& cpu) noexcept;
+	}
+
+	class BinaryTraceSink final : public TraceSink
+	{
+	public:
+		//******************************
+		// Constructor, takes the path
+		// of the trace file and how many
+		// records go between keyframes
+		//
+		// Throws -1 when the files could
+		// not be created
+		//******************************
+		BinaryTraceSink(const std::string& filename, uint64_t keyframe_interval = 1 << 20);
+
+		//******************************
+		// Destructor, flushes whatever
+		// is left and closes the files
+		//******************************
+		inline ~BinaryTraceSink() noexcept { close(); }
+
+		//******************************
+		// Record an instruction
+		//
+		// Only waits if the background
+		// writer has fallen a whole ring
+		// behind
+		//******************************
+		void trace(const i8080& cpu) noexcept override;
+
+		//******************************
+		// Flush everything recorded so
+		// far and close the files;
+		// anything traced afterwards is
+		// dropped
+		//******************************
+		void close() noexcept;
+
+		//******************************
+		// Get the number of records
+		//******************************
+		inline uint64_t get_records() const noexcept { return records; }
+
+		//******************************
+		// Get the number of times the
+		// ring was full and we waited
+		//******************************
+		inline uint64_t get_stalls() const noexcept { return stalls; }
+	private:
+		static const size_t ring_size = 1 << 16;
+		static const uint8_t keyframe_slots = 2;
+
+		uint64_t keyframe_interval;
+		uint64_t records = 0;
+		uint64_t stalls = 0;
+
+		// records on their way to the writer
+		std::unique_ptr<SpscQueue<trace::Record, ring_size>> ring;
+
+		// keyframes are too big to queue by value, so the two threads
+		// pass indices to a small pool of them back and forth
+		std::unique_ptr<trace::Keyframe[]> keyframes;
+		SpscQueue<uint8_t, 4> filled;
+		SpscQueue<uint8_t, 4> empty;
+
+		std::ofstream record_file;
+		std::ofstream keyframe_file;
+		std::thread writer;
+		std::atomic<bool> closing{ false };
+
+		//******************************
+		// The background writer's loop
+		//******************************
+		void write_loop();
+	};
+}
@@ -0,0 +1,68 @@
+//**************************************
+// triple_buffer.h
+//
+// Holds a lock-free triple buffer for
+// handing the newest value from one
+// producer thread to one consumer
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace i8080
+{
+	template<typename T>
+	class TripleBuffer final
+	{
+	public:
+		//******************************
+		// Get the buffer the producer
+		// fills in next
+		//******************************
+		inline T& back() noexcept { return buffers[back_index]; }
+
+		//******************************
+		// Hand the back buffer over to
+		// the consumer, replacing any
+		// value it hasn't picked up yet
+		//******************************
+		void publish() noexcept
+		{
+			back_index = middle.exchange(back_index | fresh, std::memory_order_acq_rel) & ~fresh;
+		}
+
+		//******************************
+		// Pick up the newest published
+		// value, if there is one
+		//
+		// Returns false when nothing
+		// new has been published
+		//******************************
+		bool update() noexcept
+		{
+			if (!(middle.load(std::memory_order_relaxed) & fresh)) return false;
+			front_index = middle.exchange(front_index, std::memory_order_acq_rel) & ~fresh;
+			return true;
+		}
+
+		//******************************
+		// Get the buffer the consumer
+		// is currently reading
+		//******************************
+		inline const T& front() const noexcept { return buffers[front_index]; }
+	private:
+		// set on the middle index when it holds a value
+		// the consumer hasn't seen yet
+		static const uint8_t fresh = 0x4;
+
+		std::array<T, 3> buffers{};
+		uint8_t back_index = 0;
+		alignas(64) std::atomic<uint8_t> middle{ 1 };
+		alignas(64) uint8_t front_index = 2;
+	};
+}
@@ -0,0 +1,194 @@
+//**************************************
+// main.cpp
+//
+// Driver for the lockstep build, which
+// runs the test programs on a reference
+// CPU and a candidate CPU side by side
+// and fails on the first mismatch
+//
+// Author: Nathan Ikola
+// nathan.ikola@gmail.com
+//**************************************
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "assembler.h"
+#include "i8080.h"
+#include "lockstep.h"
+
+//**************************************
+// A trace sink that does nothing, so a
+// CPU runs its traced loop
+//**************************************
+class NullTraceSink final : public i8080::TraceSink
+{
+public:
+	void trace(const i8080::i8080&) noexcept override {}
+};
+
+//**************************************
+// Switch the candidate over to the
+// execution path under test
+//
+// For now that's the instrumented loop
+// (tracing plus hashing every step),
+// which must never change behavior;
+// faster backends get hooked in here
+//**************************************
+void make_candidate(i8080::i8080& cpu, NullTraceSink& sink)
+{
+	cpu.set_trace(&sink);
+	cpu.enable_state_hash(1);
+}
+
+//**************************************
+// The Space Invaders video interrupts,
+// RST 1 at mid screen and RST 2 at the
+// end of each frame
+//**************************************
+class VideoInterrupts final
+{
+public:
+	VideoInterrupts(i8080::i8080& cpu) : cpu(cpu) { schedule(half_frame); }
+private:
+	// 2 MHz split into 120 half frames
+	static const uint64_t half_frame = 2000000 / 120;
+
+	i8080::i8080& cpu;
+
+	void schedule(uint64_t at)
+	{
+		cpu.get_scheduler().schedule(at, [this](uint64_t due)
+		{
+			cpu.interrupt((due / half_frame) & 1 ? 1 : 2);
+			schedule(due + half_frame);
+		});
+	}
+};
+
+//**************************************
+// Run two CPUs loaded with the same
+// program in lockstep
+//
+// Returns false on a mismatch
+//**************************************
+bool compare(const std::string& name, i8080::i8080& reference, i8080::i8080& candidate, uint64_t instructions, bool video)
+{
+	NullTraceSink sink;
+	make_candidate(candidate, sink);
+
+	// the devices only exist for the length of the run
+	std::unique_ptr<VideoInterrupts> reference_video, candidate_video;
+	if (video)
+	{
+		reference_video.reset(new VideoInterrupts(reference));
+		candidate_video.reset(new VideoInterrupts(candidate));
+	}
+
+	i8080::Lockstep lockstep(reference, candidate);
+	i8080::Divergence divergence = lockstep.run(instructions);
+
+	std::cout << name << ": " << lockstep.get_instructions() << " instructions, "
+		<< reference.get_interrupts() << " interrupts, ";
+	if (!divergence.found)
+	{
+		std::cout << "ok\n";
+		return true;
+	}
+	std::cout << "MISMATCH\n" << i8080::describe(divergence);
+	return false;
+}
+
+//**************************************
+// Run a program file in lockstep
+//
+// Returns false on a mismatch
+//**************************************
+bool check(const std::string& name, const std::string& path, uint16_t offset, uint64_t instructions, bool video)
+{
+	i8080::i8080 reference(path.c_str(), 0xFFFF, offset);
+	i8080::i8080 candidate(path.c_str(), 0xFFFF, offset);
+	return compare(name, reference, candidate, instructions, video);
+}
+
+//**************************************
+// A program that keeps taking the video
+// interrupts: it waits in HLT or in a
+// DI/EI section, and the handlers end in
+// EI; RET, so the instruction after EI
+// and the interrupt timing around it get
+// compared too
+//**************************************
+const char* const interrupt_source = R"(
+		ORG 0
+		JMP start
+		ORG 08H
+		JMP isr
+		ORG 10H
+		JMP isr
+
+		ORG 40H
+start:	LXI SP, 1000H
+		EI
+loop:	INX B
+		MOV A, C
+		ANI 3
+		JNZ busy
+		HLT
+		JMP loop
+busy:	DI
+		INX D
+		EI
+		JMP loop
+
+isr:	PUSH PSW
+		PUSH H
+		LXI H, count
+		INR M
+		POP H
+		POP PSW
+		EI
+		RET
+count:	DB 0
+		END start
+)";
+
+//**************************************
+// Run the interrupt program in lockstep
+//
+// Returns false on a mismatch, or if no
+// interrupt was ever taken
+//**************************************
+bool check_interrupts(uint64_t instructions)
+{
+	i8080::Assembler assembler;
+	assembler.assemble(interrupt_source);
+
+	i8080::i8080 reference, candidate;
+	for (i8080::i8080* cpu : { &reference, &candidate })
+	{
+		assembler.load(*cpu);
+		cpu->set_pc(assembler.get_entry());
+	}
+
+	if (!compare("interrupts", reference, candidate, instructions, true)) return false;
+	if (reference.get_interrupts() != 0) return true;
+	std::cout << "interrupts: NO INTERRUPTS TAKEN\n";
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	// the programs live with the main project
+	std::string dir = argc > 1 ? argv[1] : "../i8080";
+
+	bool ok = check("cpudiag", dir + "/cpudiag.bin", 0x100, 10000000, false);
+	// the ROM's own startup code; it never gets as far as EI here,
+	// so interrupts are covered by the program below
+	ok = check("invaders", dir + "/invaders.bin", 0x0, 16000000, true) && ok;
+	ok = check_interrupts(1000000) && ok;
+
+	return ok ? 0 : 1;
+}